@@ -0,0 +1,485 @@
+#ifndef BATCH_SIMULATOR_CPP
+#define BATCH_SIMULATOR_CPP
+
+/*
+ * File:   BatchSimulator.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "BatchSimulator.h"
+#include "SimulationEngine.h"
+#include "LifeSimulator.h"
+#include "ParallelFor.h"
+#include "BitKernels.h"
+
+// rows handed to a thread at a time
+static const int bandRows = 16;
+// starting threads costs about as much as stepping this many cells, smaller
+// boxes are not worth splitting up
+static const long long int cellsPerThread = 1 << 14;
+
+// a batch spends about as long on a cell as a LifeSimulator does on this
+// many cells, which is why it is only worth it while most rules are alive
+// all over the union box
+static const long long int singleCellCost = 24;
+
+// returns how many threads a box of the given size is worth
+static int getThreadNum(const long long int cellCount, const int maxThrNum) {
+    return std::max(1LL, std::min<long long int> (maxThrNum,
+            cellCount / cellsPerThread));
+}
+
+BatchSimulator::BatchSimulator(const std::vector<std::string>& chromosomes,
+        const int gridSize, const int fillPercent, const unsigned int seed) {
+    if (chromosomes.empty()
+            || chromosomes.size() > static_cast<size_t> (maxRuleCount))
+        throw "A batch takes 1 to 64 rules";
+    this->chromosomes = chromosomes;
+    this->ruleCount = chromosomes.size();
+    this->allLanes = this->ruleCount == 64 ? ~uint64_t(0)
+            : (uint64_t(1) << this->ruleCount) - 1;
+    this->runningLanes = this->allLanes;
+    this->alternatingLanes = 0;
+    std::fill(&this->birthLanes[0][0], &this->birthLanes[0][0] + 18, 0);
+    std::fill(&this->surviveLanes[0][0], &this->surviveLanes[0][0] + 18, 0);
+    for (int l = 0; l < this->ruleCount; l++) {
+        const SimulationEngine::RuleMasks masks
+                = SimulationEngine::getRuleMasks(chromosomes[l]);
+        const uint64_t lane = uint64_t(1) << l;
+        for (int n = 0; n <= 8; n++) {
+            if (masks.evenBirth & (1 << n))
+                this->birthLanes[0][n] |= lane;
+            if (masks.evenSurvive & (1 << n))
+                this->surviveLanes[0][n] |= lane;
+            if (masks.oddBirth & (1 << n))
+                this->birthLanes[1][n] |= lane;
+            if (masks.oddSurvive & (1 << n))
+                this->surviveLanes[1][n] |= lane;
+        }
+        if (masks.evenBirth != masks.oddBirth
+                || masks.evenSurvive != masks.oddSurvive)
+            this->alternatingLanes |= lane;
+    }
+    this->generation = 0;
+    this->settledClasses.assign(this->ruleCount, 0);
+    this->laneRowBlocks = 0;
+    // leave some dead cells around the soup so it has room to grow before
+    // the grid is resized
+    this->gridWidth = gridSize + 64;
+    this->gridHeight = gridSize + 64;
+    this->originX = -32;
+    this->originY = -32;
+    this->cells.assign(static_cast<size_t> (this->gridWidth)
+            * this->gridHeight, 0);
+    this->nextCells.assign(this->cells.size(), 0);
+    SimulationEngine::fillSoup(gridSize, fillPercent, seed,
+            [&](const int x, const int y) {
+        this->cells[static_cast<size_t> (y - this->originY) * this->gridWidth
+                + x - this->originX] = this->allLanes;
+    });
+    this->cellsBox.minX = -this->originX;
+    this->cellsBox.maxX = -this->originX + gridSize - 1;
+    this->cellsBox.minY = -this->originY;
+    this->cellsBox.maxY = -this->originY + gridSize - 1;
+    this->findBoundingBoxes(1);
+}
+
+void BatchSimulator::run(const int genNum,
+        const std::function<void(const int, const GenerationFrame&)>& onFrame,
+        const bool stopWhenSettled, const int maxThrNum) {
+    // same loop as SimulationEngine::run, once for every rule
+    std::vector<GenerationFrame> previous(this->ruleCount);
+    std::vector<ShapeHistory> seenShapes(this->ruleCount);
+    // hands generation i of rule l over and returns true if the rule stops
+    auto handOver = [&](const int l, const int i, GenerationFrame&& frame) {
+        onFrame(l, frame);
+        // same check as compare_rle in golly-script.py
+        if (i > 0 && frame.sameShape(previous[l])) {
+            if (i < genNum)
+                this->settledClasses[l] = 1;
+            return true;
+        }
+        if (stopWhenSettled && i < genNum) {
+            const int parity = (this->alternatingLanes >> l) & 1 ? i % 2 : 0;
+            if (seenShapes[l].addUnlessSeen(frame, parity)) {
+                this->settledClasses[l] = 2;
+                return true;
+            }
+        }
+        previous[l] = std::move(frame);
+        return false;
+    };
+    std::vector<char> stopped(this->ruleCount, 0);
+    int i = this->generation;
+    for (; i <= genNum && this->runningLanes; i++) {
+        this->transposeBox(maxThrNum);
+        const long long int area = static_cast<long long int> (
+                this->unionBox.maxX - this->unionBox.minX + 1)
+                * (this->unionBox.maxY - this->unionBox.minY + 1);
+        const std::vector<int> rules = this->getRunningRules();
+        parallelFor(rules.size(), getThreadNum(area, maxThrNum),
+                [&](const int t) {
+            const int l = rules[t];
+            // stop if universe is empty
+            if (!((this->aliveLanes >> l) & 1)) {
+                this->settledClasses[l] = 1;
+                stopped[l] = 1;
+                return;
+            }
+            stopped[l] = handOver(l, i, this->getFrame(l));
+        });
+        for (const int l : rules) {
+            if (stopped[l])
+                this->runningLanes &= ~(uint64_t(1) << l);
+        }
+        if (i == genNum || !this->runningLanes || this->singleRulesFaster())
+            break;
+        this->step(maxThrNum);
+    }
+    if (i >= genNum || !this->runningLanes)
+        return;
+    // the rules still running have their frames of generation i in previous,
+    // every one of them carries on in a LifeSimulator of its own
+    const std::vector<int> rules = this->getRunningRules();
+    parallelFor(rules.size(), maxThrNum, [&](const int t) {
+        const int l = rules[t];
+        LifeSimulator sim(this->chromosomes[l], previous[l], i);
+        for (int g = i + 1; g <= genNum; g++) {
+            sim.step();
+            if (sim.empty()) {
+                this->settledClasses[l] = 1;
+                break;
+            }
+            if (handOver(l, g, sim.getFrame()))
+                break;
+        }
+    });
+    this->runningLanes = 0;
+}
+
+std::vector<int> BatchSimulator::getRunningRules() const {
+    std::vector<int> rules;
+    for (int l = 0; l < this->ruleCount; l++) {
+        if ((this->runningLanes >> l) & 1)
+            rules.push_back(l);
+    }
+    return rules;
+}
+
+bool BatchSimulator::singleRulesFaster() const {
+    // a LifeSimulator goes through the words around its own box, 64 cells at
+    // a time, while the batch goes through every cell of the union box
+    long long int singleCells = 0;
+    for (int l = 0; l < this->ruleCount; l++) {
+        if (!((this->runningLanes >> l) & 1))
+            continue;
+        const CellBox& box = this->laneBoxes[l];
+        singleCells += (box.maxY - box.minY + 3) * 64LL
+                * ((box.maxX - box.minX + 2) / 64 + 2);
+    }
+    const long long int batchCells = (this->unionBox.maxY
+            - this->unionBox.minY + 3) * static_cast<long long int> (
+            this->unionBox.maxX - this->unionBox.minX + 3);
+    return singleCells < batchCells * singleCellCost;
+}
+
+void BatchSimulator::step(const int maxThrNum) {
+    this->ensureMargin();
+    const int parity = this->generation % 2;
+    // the rule of every lane for each neighbour count folded into one word:
+    // the birth lanes, flipped to the survival lanes where the cell is alive
+    uint64_t birth[9];
+    uint64_t flip[9];
+    for (int n = 0; n <= 8; n++) {
+        birth[n] = this->birthLanes[parity][n];
+        flip[n] = birth[n] ^ this->surviveLanes[parity][n];
+    }
+    const uint64_t running = this->runningLanes;
+    // clear whatever is left in the buffer from two generations ago
+    for (int y = this->nextBox.minY; y <= this->nextBox.maxY; y++) {
+        uint64_t* gridRow = this->nextCells.data()
+                + static_cast<size_t> (y) * this->gridWidth;
+        std::fill(gridRow + this->nextBox.minX,
+                gridRow + this->nextBox.maxX + 1, 0);
+    }
+    // new live cells can only show up one cell outside the current box
+    CellBox written;
+    written.minX = this->unionBox.minX - 1;
+    written.maxX = this->unionBox.maxX + 1;
+    written.minY = this->unionBox.minY - 1;
+    written.maxY = this->unionBox.maxY + 1;
+    const int rowCount = written.maxY - written.minY + 1;
+    const int bandCount = (rowCount + bandRows - 1) / bandRows;
+    const long long int area = static_cast<long long int> (rowCount)
+            * (written.maxX - written.minX + 1);
+    parallelFor(bandCount, getThreadNum(area, maxThrNum), [&](const int band) {
+        const int firstRow = written.minY + band * bandRows;
+        const int lastRow = std::min(written.maxY, firstRow + bandRows - 1);
+        for (int y = firstRow; y <= lastRow; y++) {
+            const uint64_t* above = this->cells.data()
+                    + static_cast<size_t> (y - 1) * this->gridWidth;
+            const uint64_t* row = above + this->gridWidth;
+            const uint64_t* below = row + this->gridWidth;
+            uint64_t* outRow = this->nextCells.data()
+                    + static_cast<size_t> (y) * this->gridWidth;
+            for (int x = written.minX; x <= written.maxX; x++) {
+                // add the 8 neighbour words up into 4 bit planes with the
+                // same full adders LifeSimulator uses
+                const uint64_t n0 = above[x - 1], n1 = above[x], n2 = above[x + 1];
+                const uint64_t n3 = row[x - 1], n4 = row[x + 1];
+                const uint64_t n5 = below[x - 1], n6 = below[x], n7 = below[x + 1];
+                uint64_t t0 = n0 ^ n1;
+                uint64_t s0 = t0 ^ n2;
+                uint64_t c0 = (n0 & n1) | (t0 & n2);
+                uint64_t t1 = n3 ^ n4;
+                uint64_t s1 = t1 ^ n5;
+                uint64_t c1 = (n3 & n4) | (t1 & n5);
+                uint64_t s2 = n6 ^ n7;
+                uint64_t c2 = n6 & n7;
+                uint64_t t3 = s0 ^ s1;
+                uint64_t bit0 = t3 ^ s2;
+                uint64_t c3 = (s0 & s1) | (t3 & s2);
+                uint64_t t4 = c0 ^ c1;
+                uint64_t s4 = t4 ^ c2;
+                uint64_t c4 = (c0 & c1) | (t4 & c2);
+                uint64_t bit1 = s4 ^ c3;
+                uint64_t c5 = s4 & c3;
+                uint64_t bit2 = c4 ^ c5;
+                uint64_t bit3 = c4 & c5;
+                // pick the rule bit of every lane for its count with a tree
+                // of multiplexers, one level per bit plane. Counts only go up
+                // to 8 so bit3 is only set if the others are not
+                const uint64_t self = row[x];
+                uint64_t rule[9];
+                for (int n = 0; n <= 8; n++) {
+                    rule[n] = birth[n] ^ (self & flip[n]);
+                }
+                auto pick = [](const uint64_t a, const uint64_t b,
+                        const uint64_t sel) {
+                    return a ^ ((a ^ b) & sel);
+                };
+                const uint64_t r01 = pick(rule[0], rule[1], bit0);
+                const uint64_t r23 = pick(rule[2], rule[3], bit0);
+                const uint64_t r45 = pick(rule[4], rule[5], bit0);
+                const uint64_t r67 = pick(rule[6], rule[7], bit0);
+                const uint64_t r03 = pick(r01, r23, bit1);
+                const uint64_t r47 = pick(r45, r67, bit1);
+                const uint64_t r07 = pick(r03, r47, bit2);
+                outRow[x] = pick(r07, rule[8], bit3) & running;
+            }
+        }
+    });
+    std::swap(this->cells, this->nextCells);
+    this->nextBox = this->cellsBox;
+    this->cellsBox = written;
+    this->generation++;
+    this->findBoundingBoxes(maxThrNum);
+}
+
+void BatchSimulator::ensureMargin() {
+    if (this->unionBox.minX >= 2 && this->unionBox.maxX <= this->gridWidth - 3
+            && this->unionBox.minY >= 2
+            && this->unionBox.maxY <= this->gridHeight - 3)
+        return;
+    // grow by half the size on every side
+    const int padX = std::max(32, this->gridWidth / 2);
+    const int padY = std::max(32, this->gridHeight / 2);
+    const int newWidth = this->gridWidth + 2 * padX;
+    const int newHeight = this->gridHeight + 2 * padY;
+    std::vector<uint64_t> grown(static_cast<size_t> (newWidth) * newHeight, 0);
+    for (int y = this->cellsBox.minY; y <= this->cellsBox.maxY; y++) {
+        const uint64_t* oldRow = this->cells.data()
+                + static_cast<size_t> (y) * this->gridWidth;
+        uint64_t* newRow = grown.data()
+                + static_cast<size_t> (y + padY) * newWidth + padX;
+        std::copy(oldRow + this->cellsBox.minX,
+                oldRow + this->cellsBox.maxX + 1, newRow + this->cellsBox.minX);
+    }
+    this->cells.swap(grown);
+    this->nextCells.assign(this->cells.size(), 0);
+    this->gridWidth = newWidth;
+    this->gridHeight = newHeight;
+    this->originX -= padX;
+    this->originY -= padY;
+    auto moveBox = [&](CellBox& box) {
+        box.minX += padX;
+        box.maxX += padX;
+        box.minY += padY;
+        box.maxY += padY;
+    };
+    moveBox(this->cellsBox);
+    moveBox(this->unionBox);
+    for (int l = 0; l < this->ruleCount; l++) {
+        moveBox(this->laneBoxes[l]);
+    }
+    this->nextBox = CellBox();
+}
+
+void BatchSimulator::findBoundingBoxes(const int maxThrNum) {
+    const CellBox& box = this->cellsBox;
+    const int rowCount = std::max(0, box.maxY - box.minY + 1);
+    const int colCount = std::max(0, box.maxX - box.minX + 1);
+    const int bandCount = (rowCount + bandRows - 1) / bandRows;
+    // OR of every row, and of every column within each band
+    std::vector<uint64_t> rowLanes(rowCount, 0);
+    std::vector<uint64_t> colLanes(static_cast<size_t> (bandCount) * colCount,
+            0);
+    parallelFor(bandCount, getThreadNum(static_cast<long long int> (rowCount)
+            * colCount, maxThrNum), [&](const int band) {
+        uint64_t* bandCols = colLanes.data()
+                + static_cast<size_t> (band) * colCount;
+        const int firstRow = band * bandRows;
+        const int lastRow = std::min(rowCount, firstRow + bandRows);
+        for (int r = firstRow; r < lastRow; r++) {
+            const uint64_t* gridRow = this->cells.data()
+                    + static_cast<size_t> (box.minY + r) * this->gridWidth
+                    + box.minX;
+            uint64_t rowOr = 0;
+            for (int c = 0; c < colCount; c++) {
+                rowOr |= gridRow[c];
+                bandCols[c] |= gridRow[c];
+            }
+            rowLanes[r] = rowOr;
+        }
+    });
+    for (int band = 1; band < bandCount; band++) {
+        const uint64_t* bandCols = colLanes.data()
+                + static_cast<size_t> (band) * colCount;
+        for (int c = 0; c < colCount; c++) {
+            colLanes[c] |= bandCols[c];
+        }
+    }
+    // every lane's box edge is the first row or column its bit shows up in
+    // from that side
+    auto findEdges = [&](const uint64_t* lanes, const int count,
+            const int offset, int CellBox::* minEdge, int CellBox::* maxEdge) {
+        uint64_t seen = 0;
+        for (int i = 0; i < count; i++) {
+            uint64_t fresh = lanes[i] & ~seen;
+            seen |= lanes[i];
+            for (; fresh != 0; fresh &= fresh - 1) {
+                this->laneBoxes[__builtin_ctzll(fresh)].*minEdge = offset + i;
+            }
+        }
+        seen = 0;
+        for (int i = count - 1; i >= 0; i--) {
+            uint64_t fresh = lanes[i] & ~seen;
+            seen |= lanes[i];
+            for (; fresh != 0; fresh &= fresh - 1) {
+                this->laneBoxes[__builtin_ctzll(fresh)].*maxEdge = offset + i;
+            }
+        }
+        return seen;
+    };
+    for (int l = 0; l < this->ruleCount; l++) {
+        this->laneBoxes[l] = CellBox();
+    }
+    this->aliveLanes = findEdges(rowLanes.data(), rowCount, box.minY,
+            &CellBox::minY, &CellBox::maxY);
+    findEdges(colLanes.data(), colCount, box.minX,
+            &CellBox::minX, &CellBox::maxX);
+    this->unionBox = CellBox();
+    bool first = true;
+    for (int l = 0; l < this->ruleCount; l++) {
+        if (!((this->aliveLanes >> l) & 1))
+            continue;
+        const CellBox& lane = this->laneBoxes[l];
+        if (first) {
+            this->unionBox = lane;
+            first = false;
+            continue;
+        }
+        this->unionBox.minX = std::min(this->unionBox.minX, lane.minX);
+        this->unionBox.maxX = std::max(this->unionBox.maxX, lane.maxX);
+        this->unionBox.minY = std::min(this->unionBox.minY, lane.minY);
+        this->unionBox.maxY = std::max(this->unionBox.maxY, lane.maxY);
+    }
+}
+
+void BatchSimulator::transposeBox(const int maxThrNum) {
+    const CellBox& box = this->unionBox;
+    const int rowCount = std::max(0, box.maxY - box.minY + 1);
+    const int colCount = std::max(0, box.maxX - box.minX + 1);
+    const int blocks = (colCount + 63) / 64;
+    this->laneRowBlocks = blocks;
+    this->laneRows.resize(static_cast<size_t> (this->ruleCount) * rowCount
+            * blocks);
+    const size_t laneStride = static_cast<size_t> (rowCount) * blocks;
+    const int bandCount = (rowCount + bandRows - 1) / bandRows;
+    parallelFor(bandCount, getThreadNum(static_cast<long long int> (rowCount)
+            * colCount, maxThrNum), [&](const int band) {
+        const int firstRow = band * bandRows;
+        const int lastRow = std::min(rowCount, firstRow + bandRows);
+        uint64_t block[64];
+        for (int r = firstRow; r < lastRow; r++) {
+            const uint64_t* gridRow = this->cells.data()
+                    + static_cast<size_t> (box.minY + r) * this->gridWidth
+                    + box.minX;
+            for (int k = 0; k < blocks; k++) {
+                // word i holds every lane of the cell at column 64k + i, after
+                // the transpose word l holds those 64 cells of lane l
+                const int width = std::min(64, colCount - 64 * k);
+                uint64_t any = 0;
+                for (int i = 0; i < width; i++) {
+                    block[i] = gridRow[64 * k + i];
+                    any |= block[i];
+                }
+                std::fill(block + width, block + 64, 0);
+                if (any != 0)
+                    bitkernels::transpose64(block);
+                uint64_t* out = this->laneRows.data()
+                        + static_cast<size_t> (r) * blocks + k;
+                for (int l = 0; l < this->ruleCount; l++) {
+                    out[l * laneStride] = block[l];
+                }
+            }
+        }
+    });
+}
+
+GenerationFrame BatchSimulator::getFrame(const int rule) const {
+    GenerationFrame frame;
+    if (!((this->aliveLanes >> rule) & 1))
+        return frame;
+    const CellBox& box = this->laneBoxes[rule];
+    frame.resize(this->originX + box.minX, this->originY + box.minY,
+            box.maxX - box.minX + 1, box.maxY - box.minY + 1);
+    const int blocks = this->laneRowBlocks;
+    const int unionRows = this->unionBox.maxY - this->unionBox.minY + 1;
+    const long long int firstBit = box.minX - this->unionBox.minX;
+    // mask for the bits of the last word that are inside the frame
+    const int tailBits = frame.width % 64;
+    const uint64_t tailMask = tailBits == 0 ? ~uint64_t(0)
+            : (uint64_t(1) << tailBits) - 1;
+    for (int r = 0; r < frame.height; r++) {
+        const uint64_t* laneRow = this->laneRows.data()
+                + (static_cast<size_t> (rule) * unionRows
+                + box.minY - this->unionBox.minY + r) * blocks;
+        uint64_t* frameRow = frame.row(r);
+        for (int w = 0; w < frame.wordsPerRow; w++) {
+            const long long int bitPos = firstBit + 64LL * w;
+            const long long int word = bitPos / 64;
+            const int shift = bitPos % 64;
+            uint64_t bits = laneRow[word] >> shift;
+            if (shift != 0 && word + 1 < blocks)
+                bits |= laneRow[word + 1] << (64 - shift);
+            frameRow[w] = bits;
+        }
+        frameRow[frame.wordsPerRow - 1] &= tailMask;
+    }
+    return frame;
+}
+
+int BatchSimulator::getSettledClass(const int rule) const {
+    return this->settledClasses[rule];
+}
+
+int BatchSimulator::getRuleCount() const {
+    return this->ruleCount;
+}
+
+#endif /* BATCH_SIMULATOR_CPP */
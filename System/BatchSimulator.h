@@ -0,0 +1,120 @@
+/*
+ * File:   BatchSimulator.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef BATCH_SIMULATOR_H
+#define BATCH_SIMULATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include "GenerationFrame.h"
+
+// Simulates up to 64 rules on the same soup at once. Where LifeSimulator
+// packs 64 cells of one rule into a word, here every cell gets a word of its
+// own and bit l of it is the cell under rule l, so the neighbour counts of
+// all the rules are added up with the same full adders and the rules only
+// differ in the masks the counts are matched against. Every rule sees the
+// same soup, generations and stopping points it would in its own
+// LifeSimulator, the grid just covers the live cells of every rule still
+// running. That grid costs the same however many rules are alive in it, so
+// once a few rules grow far past the rest the ones still running are
+// handed to a LifeSimulator each.
+class BatchSimulator {
+public:
+    // number of rules that fit in a word
+    static const int maxRuleCount = 64;
+
+    // constructor
+    // takes the 18 char chromosomes of 1 to maxRuleCount rules and fills
+    // the gridSize x gridSize square at the origin with the same soup
+    // LifeSimulator would for the seed, for every rule
+    BatchSimulator(const std::vector<std::string>& chromosomes,
+            const int gridSize, const int fillPercent, const unsigned int seed);
+
+    // does what SimulationEngine::run does for every rule at once, handing
+    // every generation of rule r to onFrame(r, frame). Rules that stop are
+    // dropped from the batch while the rest keep going. The generations of
+    // one rule are handed over in order, but onFrame is called for
+    // different rules from up to maxThrNum threads at the same time
+    void run(const int genNum,
+            const std::function<void(const int, const GenerationFrame&)>& onFrame,
+            const bool stopWhenSettled, const int maxThrNum);
+
+    // after a run, returns the class the given rule settled into, see
+    // SimulationEngine::getSettledClass
+    int getSettledClass(const int rule) const;
+
+    // returns the number of rules in the batch
+    int getRuleCount() const;
+
+private:
+    std::vector<std::string> chromosomes;
+    int ruleCount;
+    // lanes of every rule in the batch and of the rules still running
+    uint64_t allLanes;
+    uint64_t runningLanes;
+    // bit l of birthLanes[p][n] is set if n neighbours cause a birth under
+    // rule l in generations of parity p, rules are emulated the same way
+    // SimulationEngine does it
+    uint64_t birthLanes[2][9];
+    uint64_t surviveLanes[2][9];
+    uint64_t alternatingLanes;
+    int generation;
+    std::vector<int> settledClasses;
+
+    int originX; // world x-coord of the grid's column 0
+    int originY; // world y-coord of the grid's row 0
+    int gridWidth;
+    int gridHeight;
+    std::vector<uint64_t> cells; // current generation, one word per cell
+    std::vector<uint64_t> nextCells; // buffer the next generation is built in
+
+    // a box of cells in grid coordinates, empty if minX > maxX
+    struct CellBox {
+        int minX = 0;
+        int maxX = -1;
+        int minY = 0;
+        int maxY = -1;
+    };
+    // part of each buffer that may be non-zero
+    CellBox cellsBox;
+    CellBox nextBox;
+    // bounding box of live cells of every running rule and of all of them
+    CellBox laneBoxes[maxRuleCount];
+    CellBox unionBox;
+    uint64_t aliveLanes;
+
+    // the union box transposed so every rule has its own bit-packed rows,
+    // word k of row r of rule l is at ((l * height + r) * blocks + k)
+    std::vector<uint64_t> laneRows;
+    int laneRowBlocks;
+
+    // makes the grid bigger if live cells are within two cells of its edge
+    // so the next generation and its neighbours are guaranteed to fit
+    void ensureMargin();
+
+    // advances every running rule by one generation
+    void step(const int maxThrNum);
+
+    // scans the current generation and updates the bounding boxes
+    void findBoundingBoxes(const int maxThrNum);
+
+    // fills laneRows from the union box
+    void transposeBox(const int maxThrNum);
+
+    // returns the current generation of a rule cropped to its live cells
+    GenerationFrame getFrame(const int rule) const;
+
+    // returns the rules still running in order
+    std::vector<int> getRunningRules() const;
+
+    // true if simulating the rules still running one by one would be
+    // quicker than keeping them in the batch
+    bool singleRulesFaster() const;
+};
+
+#endif /* BATCH_SIMULATOR_H */
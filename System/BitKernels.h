@@ -0,0 +1,186 @@
+/*
+ * File:   BitKernels.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef BIT_KERNELS_H
+#define BIT_KERNELS_H
+
+#include <cstdint>
+#include <cstddef>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Small kernels used on bit-packed boards where every word holds 64 cells.
+// The counting kernels pick the widest vector path the compiler has been
+// told about (-mavx512vpopcntdq, -mavx2) and fall back to the popcount
+// builtin otherwise, so they give the same results everywhere.
+
+namespace bitkernels {
+
+#if defined(__AVX2__) && !defined(__AVX512VPOPCNTDQ__)
+// counts the bits of each byte with a nibble lookup table and sums the
+// bytes into the four 64 bit lanes
+inline __m256i popcount256(const __m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2,
+            3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_and_si256(v, lowMask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+            _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+inline long long int sum256(const __m256i v) {
+    return _mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1)
+            + _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3);
+}
+#endif
+
+// returns the number of set bits in words[0] to words[count - 1]
+inline long long int popcount(const uint64_t* words, const size_t count) {
+    long long int total = 0;
+    size_t i = 0;
+#if defined(__AVX512VPOPCNTDQ__)
+    __m512i acc = _mm512_setzero_si512();
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(
+                _mm512_loadu_si512(words + i)));
+    }
+    total += _mm512_reduce_add_epi64(acc);
+#elif defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm256_add_epi64(acc, popcount256(_mm256_loadu_si256(
+                reinterpret_cast<const __m256i*> (words + i))));
+    }
+    total += sum256(acc);
+#endif
+    for (; i < count; i++) {
+        total += __builtin_popcountll(words[i]);
+    }
+    return total;
+}
+
+// returns the number of bits that differ between a and b, which is the
+// number of cells that changed between two generations laid out the same way
+inline long long int popcountXor(const uint64_t* a, const uint64_t* b,
+        const size_t count) {
+    long long int total = 0;
+    size_t i = 0;
+#if defined(__AVX512VPOPCNTDQ__)
+    __m512i acc = _mm512_setzero_si512();
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_xor_si512(
+                _mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i))));
+    }
+    total += _mm512_reduce_add_epi64(acc);
+#elif defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 4 <= count; i += 4) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (b + i));
+        acc = _mm256_add_epi64(acc, popcount256(_mm256_xor_si256(va, vb)));
+    }
+    total += sum256(acc);
+#endif
+    for (; i < count; i++) {
+        total += __builtin_popcountll(a[i] ^ b[i]);
+    }
+    return total;
+}
+
+// returns the number of bits set in both a and b, which is the number of
+// cells alive in both of two generations laid out the same way
+inline long long int popcountAnd(const uint64_t* a, const uint64_t* b,
+        const size_t count) {
+    long long int total = 0;
+    size_t i = 0;
+#if defined(__AVX512VPOPCNTDQ__)
+    __m512i acc = _mm512_setzero_si512();
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_and_si512(
+                _mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i))));
+    }
+    total += _mm512_reduce_add_epi64(acc);
+#elif defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 4 <= count; i += 4) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (b + i));
+        acc = _mm256_add_epi64(acc, popcount256(_mm256_and_si256(va, vb)));
+    }
+    total += sum256(acc);
+#endif
+    for (; i < count; i++) {
+        total += __builtin_popcountll(a[i] & b[i]);
+    }
+    return total;
+}
+
+// ORs srcBits bits of src into dst starting at bit dstBitPos of dst, used to
+// place a row that starts at some x-coord into a wider row
+inline void orBitsAt(uint64_t* dst, const long long int dstBitPos,
+        const uint64_t* src, const int srcBits) {
+    const long long int firstWord = dstBitPos / 64;
+    const int shift = dstBitPos % 64;
+    const int srcWords = (srcBits + 63) / 64;
+    for (int w = 0; w < srcWords; w++) {
+        dst[firstWord + w] |= src[w] << shift;
+        // the high bits spill into the next word, unless they are padding
+        if (shift != 0 && (64LL * w + 64 - shift) < srcBits)
+            dst[firstWord + w + 1] |= src[w] >> (64 - shift);
+    }
+}
+
+// sets count bits of dst starting at bit start, a whole word at a time
+inline void setBitRange(uint64_t* dst, const long long int start,
+        const long long int count) {
+    if (count <= 0)
+        return;
+    const long long int last = start + count - 1;
+    const long long int firstWord = start / 64;
+    const long long int lastWord = last / 64;
+    const uint64_t firstMask = ~uint64_t(0) << (start % 64);
+    const uint64_t lastMask = ~uint64_t(0) >> (63 - last % 64);
+    if (firstWord == lastWord) {
+        dst[firstWord] |= firstMask & lastMask;
+        return;
+    }
+    dst[firstWord] |= firstMask;
+    for (long long int w = firstWord + 1; w < lastWord; w++) {
+        dst[w] = ~uint64_t(0);
+    }
+    dst[lastWord] |= lastMask;
+}
+
+// one step of transpose64: swaps the j x j blocks right of the diagonal
+// with the ones below it, j being a constant lets the loops be unrolled
+template <int j>
+inline void transposeStage(uint64_t* rows, const uint64_t mask) {
+    for (int k0 = 0; k0 < 64; k0 += 2 * j) {
+        for (int k = k0; k < k0 + j; k++) {
+            const uint64_t t = ((rows[k] >> j) ^ rows[k + j]) & mask;
+            rows[k] ^= t << j;
+            rows[k + j] ^= t;
+        }
+    }
+}
+
+// transposes a 64x64 bit matrix in place, bit c of rows[r] being the entry
+// at (r, c), by swapping ever smaller blocks across the diagonal
+inline void transpose64(uint64_t* rows) {
+    transposeStage<32>(rows, 0x00000000FFFFFFFFULL);
+    transposeStage<16>(rows, 0x0000FFFF0000FFFFULL);
+    transposeStage<8>(rows, 0x00FF00FF00FF00FFULL);
+    transposeStage<4>(rows, 0x0F0F0F0F0F0F0F0FULL);
+    transposeStage<2>(rows, 0x3333333333333333ULL);
+    transposeStage<1>(rows, 0x5555555555555555ULL);
+}
+
+} // namespace bitkernels
+
+#endif /* BIT_KERNELS_H */
@@ -0,0 +1,81 @@
+#ifndef BOARD_ARENA_CPP
+#define BOARD_ARENA_CPP
+
+/*
+ * File:   BoardArena.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <cstdlib>
+#include "BoardArena.h"
+
+thread_local BoardArena::Slot BoardArena::slot;
+// large enough for the boards of a long run of the default grid
+std::atomic<long long int> BoardArena::keepLimit{256LL << 20};
+
+// allocates the header and words words after it, throws if it can't
+static char* allocateBoard(const long long int words, const size_t headerBytes) {
+    const size_t bytes = headerBytes + words * sizeof (uint64_t);
+    // aligned_alloc needs a multiple of the alignment
+    char* memory = static_cast<char*> (std::aligned_alloc(64,
+            (bytes + 63) / 64 * 64));
+    if (memory == nullptr)
+        throw "Unable to allocate gameBoard";
+    return memory;
+}
+
+BoardArena::Slot::~Slot() {
+    std::free(this->data);
+}
+
+uint64_t* BoardArena::acquire(const long long int words) {
+    char* memory;
+    if (slot.inUse) {
+        memory = allocateBoard(words, sizeof (Header));
+        reinterpret_cast<Header*> (memory)->owner = nullptr;
+    } else {
+        if (slot.data == nullptr || slot.capacity < words) {
+            // nothing in the old memory is needed, so it isn't copied over
+            std::free(slot.data);
+            slot.data = nullptr;
+            slot.capacity = 0;
+            slot.data = allocateBoard(words, sizeof (Header));
+            slot.capacity = words;
+            reinterpret_cast<Header*> (slot.data)->owner = &slot;
+        }
+        slot.inUse = true;
+        memory = slot.data;
+    }
+    return reinterpret_cast<uint64_t*> (memory + sizeof (Header));
+}
+
+void BoardArena::release(uint64_t* board) {
+    if (board == nullptr)
+        return;
+    char* memory = reinterpret_cast<char*> (board) - sizeof (Header);
+    Slot* owner = reinterpret_cast<Header*> (memory)->owner;
+    if (owner == nullptr) {
+        std::free(memory);
+        return;
+    }
+    owner->inUse = false;
+    // only the owner's thread may free its memory
+    if (owner == &slot && slot.capacity * (long long int) sizeof (uint64_t)
+            > keepLimit.load())
+        trim();
+}
+
+void BoardArena::trim() {
+    if (slot.inUse)
+        return;
+    std::free(slot.data);
+    slot.data = nullptr;
+    slot.capacity = 0;
+}
+
+void BoardArena::setKeepLimit(const long long int bytes) {
+    keepLimit.store(bytes);
+}
+
+#endif /* BOARD_ARENA_CPP */
@@ -0,0 +1,56 @@
+/*
+ * File:   BoardArena.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef BOARD_ARENA_H
+#define BOARD_ARENA_H
+
+#include <cstdint>
+#include <atomic>
+
+// Memory for the gameBoard of a ConwayClassifier, kept by every thread and
+// handed to the next classifier made on it, so a worker classifying one
+// rule after another reuses pages that are already mapped instead of
+// having a fresh, zeroed allocation faulted in for every rule. The memory
+// only grows when a bigger board is needed. Memory handed out is not
+// cleared, the classifier clears every word before it fills it.
+// A second board taken on a thread while its memory is in use gets memory
+// of its own, which is freed when it is given back. A board can be given
+// back on another thread, but has to be before the thread it was taken on
+// exits
+class BoardArena {
+public:
+    // returns memory for words words, throws if it can't be allocated
+    static uint64_t* acquire(const long long int words);
+
+    // gives back memory returned by acquire, which may be nullptr
+    static void release(uint64_t* board);
+
+    // frees the memory the calling thread keeps
+    static void trim();
+
+    // most bytes a thread keeps once a board is given back, bigger boards
+    // are freed. Applies to every thread
+    static void setKeepLimit(const long long int bytes);
+
+private:
+    // memory of one thread, freed when the thread exits
+    struct Slot {
+        char* data = nullptr; // the header and then the board
+        long long int capacity = 0; // words
+        std::atomic<bool> inUse{false};
+
+        ~Slot();
+    };
+    // comes before every board, padded so the board stays 64 byte aligned
+    // for the vector kernels. owner is nullptr for memory of its own
+    struct alignas(64) Header {
+        Slot* owner;
+    };
+    static thread_local Slot slot;
+    static std::atomic<long long int> keepLimit;
+};
+
+#endif /* BOARD_ARENA_H */
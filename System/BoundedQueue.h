@@ -0,0 +1,76 @@
+/*
+ * File:   BoundedQueue.h
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <cstddef>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+
+// Queue between threads that make items and threads that use them up,
+// holding at most capacity items so a producer that is ahead of its
+// consumers blocks instead of piling up work. Once closed, pushes fail and
+// pops drain what is left and then fail too, which is how either side tells
+// the other it is done (or gave up).
+template<typename T>
+class BoundedQueue {
+public:
+    // constructor
+    // capacity is the most items held at once, at least 1
+    explicit BoundedQueue(const size_t capacity) {
+        this->capacity = capacity > 0 ? capacity : 1;
+        this->closed = false;
+    }
+
+    // adds an item, waiting while the queue is full. Returns false without
+    // adding it if the queue is closed
+    bool push(T item) {
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->notFull.wait(guard, [this]() {
+            return this->closed || this->items.size() < this->capacity;
+        });
+        if (this->closed)
+            return false;
+        this->items.push(std::move(item));
+        this->notEmpty.notify_one();
+        return true;
+    }
+
+    // takes the oldest item, waiting while the queue is empty. Returns
+    // false once the queue is closed and empty
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->notEmpty.wait(guard, [this]() {
+            return this->closed || !this->items.empty();
+        });
+        if (this->items.empty())
+            return false;
+        item = std::move(this->items.front());
+        this->items.pop();
+        this->notFull.notify_one();
+        return true;
+    }
+
+    // stops any more items from being pushed and wakes every waiting thread
+    void close() {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->closed = true;
+        this->notFull.notify_all();
+        this->notEmpty.notify_all();
+    }
+
+private:
+    std::queue<T> items;
+    size_t capacity;
+    bool closed;
+    std::mutex lock;
+    std::condition_variable notFull; // signalled when an item is taken
+    std::condition_variable notEmpty; // signalled when an item is added
+};
+
+#endif /* BOUNDED_QUEUE_H */
@@ -0,0 +1,94 @@
+#ifndef CHECKPOINT_CPP
+#define CHECKPOINT_CPP
+
+/*
+ * File:   Checkpoint.cpp
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include "Checkpoint.h"
+
+// every checkpoint file starts with these bytes
+static const char CHECKPOINT_MAGIC[8] = {'C', 'A', 'G', 'A', 'C', 'P', '0', '1'};
+
+// writes a uint32 length and then the bytes of text
+static void writeString(std::ofstream& out, const std::string& text) {
+    uint32_t length = text.length();
+    out.write(reinterpret_cast<const char*> (&length), sizeof (length));
+    out.write(text.data(), length);
+}
+
+static bool readString(std::ifstream& in, std::string& text) {
+    uint32_t length;
+    if (!in.read(reinterpret_cast<char*> (&length), sizeof (length)))
+        return false;
+    text.assign(length, '\0');
+    return (bool) in.read(&text[0], length);
+}
+
+// the file is the magic, the run key, uint32 generation, uint32 soup seed,
+// the generator state, uint32 gene count, uint32 population size, then for
+// every Individual its uint32 packed chromosome (gene i is bit i) and double
+// Fitness, and last the cache entries. Strings are stored as a uint32 length
+// followed by their bytes
+void Checkpoint::save(const std::string& fileName) const {
+    // write next to the real file and rename it over, which is atomic
+    std::string tempName = fileName + ".tmp";
+    {
+        std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            throw "Could not write the checkpoint file";
+        out.write(CHECKPOINT_MAGIC, sizeof (CHECKPOINT_MAGIC));
+        writeString(out, this->runKey);
+        uint32_t header[4] = {(uint32_t) this->generation, this->soupSeed,
+            this->geneCount, (uint32_t) this->chromosomes.size()};
+        out.write(reinterpret_cast<const char*> (header), sizeof (header));
+        writeString(out, this->rngState);
+        for (size_t i = 0; i < this->chromosomes.size(); i++) {
+            out.write(reinterpret_cast<const char*> (&this->chromosomes[i]),
+                    sizeof (uint32_t));
+            out.write(reinterpret_cast<const char*> (&this->fitness[i]),
+                    sizeof (double));
+        }
+        writeString(out, this->cacheEntries);
+        if (!out)
+            throw "Could not write the checkpoint file";
+    }
+    if (std::rename(tempName.c_str(), fileName.c_str()) != 0)
+        throw "Could not replace the checkpoint file";
+}
+
+bool Checkpoint::load(const std::string& fileName) {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.is_open())
+        return false; // nothing saved yet
+    char magic[sizeof (CHECKPOINT_MAGIC)];
+    if (!in.read(magic, sizeof (magic))
+            || !std::equal(magic, magic + sizeof (magic), CHECKPOINT_MAGIC))
+        throw "Checkpoint file is not a checkpoint";
+    uint32_t header[4];
+    if (!readString(in, this->runKey)
+            || !in.read(reinterpret_cast<char*> (header), sizeof (header))
+            || !readString(in, this->rngState))
+        throw "Checkpoint file is truncated";
+    this->generation = header[0];
+    this->soupSeed = header[1];
+    this->geneCount = header[2];
+    this->chromosomes.assign(header[3], 0);
+    this->fitness.assign(header[3], 0);
+    for (uint32_t i = 0; i < header[3]; i++) {
+        in.read(reinterpret_cast<char*> (&this->chromosomes[i]), sizeof (uint32_t));
+        in.read(reinterpret_cast<char*> (&this->fitness[i]), sizeof (double));
+    }
+    if (!in || !readString(in, this->cacheEntries))
+        throw "Checkpoint file is truncated";
+    return true;
+}
+
+#endif /* CHECKPOINT_CPP */
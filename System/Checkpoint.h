@@ -0,0 +1,41 @@
+/*
+ * File:   Checkpoint.h
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// State of a GA run once the Fitness of a generation's population has been
+// calculated, which is everything needed to carry on from there without
+// simulating any of it again: the population and its Fitness, the state of
+// the random number generator that breeds the next generation and this
+// run's cached metrics. runKey describes the parameters the run was started
+// with, a checkpoint is only resumed by a run with the same ones.
+// The file is replaced in one go so a crash never leaves a half written
+// checkpoint behind
+struct Checkpoint {
+    std::string runKey;
+    int generation = 0;
+    unsigned int soupSeed = 0;
+    std::string rngState; // the generator written with operator<<
+    uint32_t geneCount = 0;
+    std::vector<uint32_t> chromosomes; // packed, gene i is bit i
+    std::vector<double> fitness;
+    // the run's FitnessCache entries as written by saveTo, "" without one
+    std::string cacheEntries;
+
+    // writes the checkpoint to a file, throws if it can't
+    void save(const std::string& fileName) const;
+
+    // reads the checkpoint from a file, returns false if there is no such
+    // file and throws if it isn't a checkpoint
+    bool load(const std::string& fileName);
+};
+
+#endif /* CHECKPOINT_H */
@@ -8,51 +8,260 @@
  */
 
 #include <string>
-#include <sstream>
 #include <vector>
 #include <unordered_map>
 #include <utility>
 #include <fstream>
+#include <iterator>
 #include <filesystem>
-#include <thread>
+#include <cstdlib>
+#include <algorithm>
 #include <ctype.h>
 #include "ConwayClassifier.h"
+#include "GenerationDump.h"
+#include "BitKernels.h"
+#include "ParallelFor.h"
+#include "Instrumentation.h"
+#include "BoardArena.h"
 
 ConwayClassifier::ConwayClassifier(const std::string& dataDirPath,
-        const int genNum, const int maxThrNum, const int endCalcPercent) {
-    this->generationCount = genNum + 1;
-    int statCalcLength = (int) (((double) this->generationCount / 100)
-            * (double) endCalcPercent);
-    this->statStartGen = this->generationCount - statCalcLength;
-    this->rule = this->extractRule(dataDirPath);
+        const int genNum, const int maxThrNum, const int endCalcPercent,
+        const bool sparseBoard) {
+    this->initializeGenCounts(genNum, endCalcPercent);
+    this->sparse = sparseBoard;
     this->classNum = 3; // initialize classNum
+    if (std::filesystem::is_regular_file(dataDirPath)) {
+        // one generation dump instead of a directory of .rle files, mapped
+        // once and shared by every thread
+        GenerationDumpReader dump(dataDirPath);
+        CAGA_COUNT(this->counters.filesOpened, 1);
+        CAGA_COUNT(this->counters.bytesRead, dump.getLength());
+        this->rule = dump.getRule();
+        // same as missing files, golly stopped early
+        if (dump.getGenCount() != genNum + 1) {
+            this->classNum = 1;
+            this->voidInstanceVars();
+            return;
+        }
+        std::vector<GenerationFrame> frames;
+        std::vector<uint64_t> hashes;
+        this->readGens(maxThrNum, [&](const int gen, GenerationFrame& frame) {
+            dump.decodeFrame(gen, frame);
+        }, frames, hashes);
+        this->classifyFrames(frames, hashes, genNum, maxThrNum);
+        return;
+    }
+    this->rule = this->extractRule(dataDirPath);
     // Check and see if # of files in data path is less than genNum. If so
     // set classNum to 1 and then skip the following method calls.
     // Instead, initialize the instance variables so the API is fulfilled.
     this->checkForClass1(dataDirPath, genNum);
     if (this->classNum != 1) {
-        std::vector<std::ifstream*> fileStreams = // to be used to check hdrs
-                populateIStreamVec(dataDirPath, genNum);
-        this->checkForClass2(fileStreams);
-        if (this->classNum != 2) {
-            // initialize rest of vars inside calcBoardSpecs and fillBoard
-            calcBoardSpecs(fileStreams);
-            // with necessary data grabbed now can initialize the array
-            // and other data structures
-            initializeGameBoard(genNum);
-            fillBoard(fileStreams, maxThrNum);
-            finishStats();
-        } else
-            this->voidInstanceVars();
-        // now done with file streams so deallocate them
-        this->deallocateIfstreams(fileStreams);
+        // each file is mapped, decoded and unmapped again in one go
+        std::vector<GenerationFrame> frames;
+        std::vector<uint64_t> hashes;
+        this->readGens(maxThrNum, [&](const int gen, GenerationFrame& frame) {
+            RleReader reader(this->getGenPath(dataDirPath, gen));
+            CAGA_COUNT(this->counters.filesOpened, 1);
+            CAGA_COUNT(this->counters.bytesRead, reader.getLength());
+            reader.decodeFrame(frame);
+        }, frames, hashes);
+        this->classifyFrames(frames, hashes, genNum, maxThrNum);
     } else
         this->voidInstanceVars();
 }
 
+ConwayClassifier::ConwayClassifier(const std::string& rule,
+        std::vector<std::istream*>& genStreams, const int genNum,
+        const int maxThrNum, const int endCalcPercent, const bool sparseBoard) {
+    this->initializeGenCounts(genNum, endCalcPercent);
+    this->sparse = sparseBoard;
+    this->rule = rule;
+    this->classNum = 3; // initialize classNum
+    // same as a missing file, the simulation stopped early
+    if ((int) genStreams.size() != genNum + 1) {
+        this->classNum = 1;
+        this->voidInstanceVars();
+    } else {
+        std::vector<GenerationFrame> frames;
+        std::vector<uint64_t> hashes;
+        this->readGens(maxThrNum, [&](const int gen, GenerationFrame& frame) {
+            std::istream* is = genStreams[gen];
+            // streams can't be mapped so read the whole thing in one go and
+            // decode it from the buffer
+            std::string text((std::istreambuf_iterator<char>(*is)),
+                    std::istreambuf_iterator<char>());
+            CAGA_COUNT(this->counters.bytesRead, text.size());
+            RleReader(text.data(), text.size()).decodeFrame(frame);
+            // now done with file so close it, in-memory streams are left alone
+            std::ifstream* fileStream = dynamic_cast<std::ifstream*> (is);
+            if (fileStream != nullptr)
+                fileStream->close();
+        }, frames, hashes);
+        this->classifyFrames(frames, hashes, genNum, maxThrNum);
+    }
+}
+
+ConwayClassifier::ConwayClassifier(const std::string& rule,
+        const std::vector<GenerationFrame>& frames, const int genNum,
+        const int maxThrNum, const int endCalcPercent, const bool sparseBoard) {
+    this->initializeGenCounts(genNum, endCalcPercent);
+    this->sparse = sparseBoard;
+    this->rule = rule;
+    this->classNum = 3; // initialize classNum
+    // the simulation stopped early so there are missing generations
+    if ((int) frames.size() != genNum + 1) {
+        this->classNum = 1;
+        this->voidInstanceVars();
+    } else {
+        std::vector<uint64_t> hashes;
+        for (auto& frame : frames) {
+            hashes.push_back(frame.shapeHash());
+        }
+        this->classifyFrames(frames, hashes, genNum, maxThrNum);
+    }
+}
+
+void ConwayClassifier::initializeGenCounts(const int genNum,
+        const int endCalcPercent) {
+    this->generationCount = genNum + 1;
+    int statCalcLength = (int) (((double) this->generationCount / 100)
+            * (double) endCalcPercent);
+    this->statStartGen = this->generationCount - statCalcLength;
+    this->sparse = false;
+    this->streaming = false;
+    this->window = nullptr;
+    this->pushedGenCount = 0;
+    this->skippedGenCount = 0;
+    this->patternRepeated = false;
+    this->expansionRatesReady = false;
+    this->phaseTimes = PhaseTimes();
+}
+
+ConwayClassifier::ConwayClassifier(const std::string& rule, const int genNum,
+        const int endCalcPercent) {
+    this->initializeGenCounts(genNum, endCalcPercent);
+    this->rule = rule;
+    this->classNum = 3; // initialize classNum
+    this->streaming = true;
+    // generation n needs n - 1 for its percent change, anything further
+    // back is kept in the run counters
+    this->window = new GenerationWindow(2, runCounterBits + 1);
+    this->voidInstanceVars(); // there is no gameBoard in streaming mode
+    this->resizeStatVecs();
+}
+
+void ConwayClassifier::pushGeneration(const GenerationFrame& frame) {
+    if (!this->streaming || this->pushedGenCount >= this->generationCount)
+        throw "No more generations can be pushed";
+    CAGA_TIME(this->phaseTimes.pushGenerations);
+    CAGA_COUNT(this->counters.cellsSet, frame.aliveCount());
+    const int gen = this->pushedGenCount++;
+    this->addGenSpecs(frame.x, frame.y, frame.width, frame.height);
+    // same check as checkForClass2, the generations are only kept until
+    // one repeats
+    if (!this->patternRepeated)
+        this->patternRepeated = this->seenShapes.addUnlessSeen(frame);
+    // once it is class 2 the stats are thrown away anyways
+    if (this->patternRepeated)
+        return;
+    if (gen < this->getRunStartGen())
+        return;
+    this->window->push(gen, frame);
+    uint64_t* planes[runCounterBits + 1];
+    for (int p = 0; p <= runCounterBits; p++) {
+        planes[p] = this->window->getStatePlane(p);
+    }
+    long long int activeCellCount = this->advanceRunCounters(
+            this->window->getGenWords(gen), this->window->getWordsPerGen(),
+            planes, gen);
+    if (gen >= this->statStartGen)
+        this->calcStreamingStats(gen, activeCellCount);
+}
+
+int ConwayClassifier::getFirstNeededGen() const {
+    return this->getRunStartGen();
+}
+
+void ConwayClassifier::skipGenerations(const int genCount) {
+    if (!this->streaming || this->pushedGenCount != this->skippedGenCount
+            || this->skippedGenCount + genCount > this->getRunStartGen())
+        throw "Only generations before the stats can be skipped";
+    for (int i = 0; i < genCount; i++) {
+        this->addGenSpecs(0, 0, 0, 0);
+    }
+    this->pushedGenCount += genCount;
+    this->skippedGenCount += genCount;
+}
+
+void ConwayClassifier::finishGenerations(const bool repeatsForever) {
+    if (!this->streaming)
+        throw "Not in streaming mode";
+    if (repeatsForever && !this->patternRepeated)
+        throw "Generations said to repeat forever never repeated";
+    if (repeatsForever || (this->pushedGenCount == this->generationCount
+            && this->patternRepeated))
+        this->classNum = 2;
+    else if (this->pushedGenCount != this->generationCount)
+        this->classNum = 1; // the simulation stopped early
+    this->seenShapes.clear();
+    if (this->classNum != 3) {
+        this->voidInstanceVars();
+        this->aliveCellRatio.clear();
+        this->percentChange.clear();
+        this->activeCellRatio.clear();
+    } else
+        this->setBoardSpecs();
+}
+
+void ConwayClassifier::calcStreamingStats(const int gen,
+        const long long int activeCellCount) {
+    const uint64_t* genWords = this->window->getGenWords(gen);
+    const long long int wordsPerGen = this->window->getWordsPerGen();
+    int width = abs(this->minMaxX[gen].second - this->minMaxX[gen].first);
+    int height = abs(this->minMaxY[gen].second - this->minMaxY[gen].first);
+    const int statIndex = gen - this->statStartGen;
+    this->aliveCellRatio[statIndex] = (double) bitkernels::popcount(genWords,
+            wordsPerGen) / (width * height);
+    if (this->window->holds(gen - 1)) {
+        this->percentChange[statIndex] = (double) bitkernels::popcountXor(
+                this->window->getGenWords(gen - 1), genWords, wordsPerGen)
+                / (width * height);
+    }
+    this->activeCellRatio[statIndex] = (double) activeCellCount
+            / (width * height);
+}
+
 ConwayClassifier::~ConwayClassifier() {
-    // need to deallocate array
-    delete[] this->gameBoard;
+    // hand the array back so the next classifier on this thread reuses it
+    BoardArena::release(this->gameBoard);
+    delete this->window;
+}
+
+void ConwayClassifier::readGens(const int maxThrNum,
+        const std::function<void(const int, GenerationFrame&)>& readGen,
+        std::vector<GenerationFrame>& frames, std::vector<uint64_t>& hashes) {
+    CAGA_TIME(this->phaseTimes.readGens);
+    frames.assign(this->generationCount, GenerationFrame());
+    hashes.assign(this->generationCount, 0);
+    parallelFor(this->generationCount, maxThrNum, [&](const int gen) {
+        readGen(gen, frames[gen]);
+        hashes[gen] = frames[gen].shapeHash();
+    });
+}
+
+void ConwayClassifier::classifyFrames(
+        const std::vector<GenerationFrame>& frames,
+        const std::vector<uint64_t>& hashes, const int genNum,
+        const int maxThrNum) {
+    this->checkForClass2(frames, hashes);
+    if (this->classNum != 2) {
+        calcBoardSpecs(frames);
+        initializeGameBoard(genNum);
+        fillBoard(frames, maxThrNum);
+        finishStats(maxThrNum);
+    } else
+        this->voidInstanceVars();
 }
 
 void ConwayClassifier::voidInstanceVars() {
@@ -62,6 +271,8 @@ void ConwayClassifier::voidInstanceVars() {
     this->height = 0;
     this->gameBoard = NULL;
     this->boardSize = 0;
+    this->wordsPerRow = 0;
+    this->wordsPerGen = 0;
 }
 
 std::string
@@ -78,6 +289,7 @@ ConwayClassifier::extractRule(const std::string& rleDataDirPath) const {
 
 void ConwayClassifier::checkForClass1(const std::string& dataDirPath,
         const int genNum) {
+    CAGA_TIME(this->phaseTimes.class1Check);
        auto dirIter = std::filesystem::directory_iterator(dataDirPath);
        int fileCount = 0;
     
@@ -91,97 +303,64 @@ void ConwayClassifier::checkForClass1(const std::string& dataDirPath,
        }
 }
 
-void ConwayClassifier::checkForClass2(std::vector<std::ifstream*>& dataFiles) {
-    std::unordered_map<std::string, int>
-            patternMap = std::unordered_map<std::string, int>();
-    std::string unneededHeader, data, pattern;
-    int genNum = 0;
-    for (auto& is : dataFiles) {
-        std::getline(*is, unneededHeader);
-        std::getline(*is, unneededHeader); // toss out headers
-        data = "";
-        pattern = "";
-        while ((*is) >> data) { // get all of encoded pattern
-            pattern += data;
-        }
-        // check if its in the hash map
-        // if it isn't, add it
-        if (patternMap.find(pattern) == std::end(patternMap)) {
-            patternMap[pattern] = genNum;
-        }// if it is set classNum to 2 and exit loop and method as it is no
-            // longer necessary to search more
-        else {
-            this->classNum = 2;
-            break;
+void ConwayClassifier::checkForClass2(
+        const std::vector<GenerationFrame>& frames,
+        const std::vector<uint64_t>& hashes) {
+    CAGA_TIME(this->phaseTimes.class2Check);
+    // maps the hash of each pattern to the generations it was seen in, those
+    // only have to be compared when a later pattern has the same hash
+    std::unordered_map<uint64_t, std::vector<int>> patternMap;
+    for (int genNum = 0; genNum < (int) frames.size(); genNum++) {
+        std::vector<int>& sameHash = patternMap[hashes[genNum]];
+        for (int prevGen : sameHash) {
+            if (frames[prevGen].sameShape(frames[genNum])) {
+                this->classNum = 2;
+                return;
+            }
         }
-        is->clear();
-        is->seekg(0, std::ios::beg); // reset ifstream for next use
-        genNum++;
+        sameHash.push_back(genNum);
     }
 }
 
-std::vector<std::ifstream*>
-ConwayClassifier::populateIStreamVec(const std::string& dataPath,
-        const int genNum) const {
-    std::vector<std::ifstream*> rVec;
-    for (int i = 0; i <= genNum; i++) {
-        std::string path = dataPath + "/" + this->rule + "_" +
-                std::to_string(i) + ".rle";
-        std::ifstream *is = new std::ifstream(path);
-        rVec.push_back(is);
-    }
-    return rVec;
+std::string ConwayClassifier::getGenPath(const std::string& dataPath,
+        const int gen) const {
+    return dataPath + "/" + this->rule + "_" + std::to_string(gen) + ".rle";
 }
 
-void ConwayClassifier::deallocateIfstreams(std::vector<std::ifstream*>&
-        streamsToClose) const {
-    for (int i = 0; i < streamsToClose.size(); i++) {
-        delete streamsToClose[i];
+void ConwayClassifier::calcBoardSpecs(
+        const std::vector<GenerationFrame>& frames) {
+    CAGA_TIME(this->phaseTimes.boardSpecs);
+    for (auto& frame : frames) {
+        this->addGenSpecs(frame.x, frame.y, frame.width, frame.height);
     }
-}
-
-// I wish this method wasn't so chonky but idk how to shorten it and still
-// have it work efficiently
-
-void ConwayClassifier::calcBoardSpecs(std::vector<std::ifstream*>& dataFiles) {
-    int minX, maxX, minY, maxY;
-    bool firstFile = true;
-    for (auto& is : dataFiles) {
-        // for each file get first and second line and read in necessary data
-        std::string firstLine, secLine;
-        std::getline(*is, firstLine);
-        std::getline(*is, secLine);
-        // calculate relative mins for given generation
-        std::pair<int, int> minInfo = this->readPos(firstLine);
-        int tempMinX = minInfo.first;
-        int tempMinY = minInfo.second;
-        std::pair<int, int> maxPr = this->readWidthHeight(secLine);
-        int tempMaxX = tempMinX + maxPr.first;
-        int tempMaxY = tempMinY + maxPr.second;
-        std::pair<int, int> xSpecs(tempMinX, tempMaxX);
-        std::pair<int, int> ySpecs(tempMinY, tempMaxY);
-        this->minMaxX.push_back(xSpecs);
-        this->minMaxY.push_back(ySpecs);
-        if (firstFile) {
-            // set max and min vars 
-            minX = tempMinX;
-            minY = tempMinY;
-            maxX = tempMaxX;
-            maxY = tempMaxY;
-            firstFile = false;
-        } else {
-            // update max and min vars as necessary
-            if (tempMinX < minX)
-                minX = tempMinX;
-            if (tempMinY < minY)
-                minY = tempMinY;
-            if (tempMaxX > maxX)
-                maxX = tempMaxX;
-            if (tempMaxY > maxY)
-                maxY = tempMaxY;
-        }
-        is->clear();
-        is->seekg(0, std::ios::beg); // reset ifstream for next use
+    this->setBoardSpecs();
+}
+
+void ConwayClassifier::addGenSpecs(const int genX, const int genY,
+        const int genWidth, const int genHeight) {
+    std::pair<int, int> xSpecs(genX, genX + genWidth);
+    std::pair<int, int> ySpecs(genY, genY + genHeight);
+    this->minMaxX.push_back(xSpecs);
+    this->minMaxY.push_back(ySpecs);
+}
+
+void ConwayClassifier::setBoardSpecs() {
+    // skipped generations don't have a bounding box
+    const int firstGen = this->skippedGenCount;
+    int minX = this->minMaxX[firstGen].first;
+    int maxX = this->minMaxX[firstGen].second;
+    int minY = this->minMaxY[firstGen].first;
+    int maxY = this->minMaxY[firstGen].second;
+    for (int gen = firstGen + 1; gen < (int) this->minMaxX.size(); gen++) {
+        // update max and min vars as necessary
+        if (this->minMaxX[gen].first < minX)
+            minX = this->minMaxX[gen].first;
+        if (this->minMaxY[gen].first < minY)
+            minY = this->minMaxY[gen].first;
+        if (this->minMaxX[gen].second > maxX)
+            maxX = this->minMaxX[gen].second;
+        if (this->minMaxY[gen].second > maxY)
+            maxY = this->minMaxY[gen].second;
     }
     this->x = minX;
     this->y = minY;
@@ -189,205 +368,262 @@ void ConwayClassifier::calcBoardSpecs(std::vector<std::ifstream*>& dataFiles) {
     this->height = maxY - minY;
 }
 
-std::pair<int, int>
-ConwayClassifier::readPos(const std::string& firstLine) const {
-    std::istringstream posStream(firstLine);
-    std::string posStr;
-    posStream >> posStr >> posStr;
-    posStr = posStr.substr(this->posQualifierLen, posStr.length()
-            - this->posQualifierLen);
-    std::pair<int, int> posPair(
-            std::stoi(this->split(posStr, ",", true)),
-            std::stoi(this->split(posStr, ",", false)));
-    return posPair;
+void ConwayClassifier::fillBoard(const std::vector<GenerationFrame>& frames,
+        const int maxThrNum) {
+    CAGA_TIME(this->phaseTimes.fillBoard);
+    // the alive cells of every stat generation and the one before the
+    // first, and the cells alive in both it and the generation before it,
+    // counted on the frames while each generation is filled in
+    const int firstGen = std::max(0, this->statStartGen - 1);
+    std::vector<long long int> aliveCounts(this->generationCount - firstGen);
+    std::vector<long long int> commonCounts(this->generationCount - firstGen);
+    parallelFor(this->generationCount, maxThrNum, [&](const int gen) {
+        const GenerationFrame& frame = frames.at(gen);
+        this->fillGen(frame, gen);
+        if (gen < firstGen)
+            return;
+        aliveCounts[gen - firstGen] = bitkernels::popcount(frame.bits.data(),
+                frame.bits.size());
+        if (gen > firstGen)
+            commonCounts[gen - firstGen] = countCommonCells(frames.at(gen - 1),
+                frame);
+    });
+    // a cell changed if it is alive in only one of the two generations, the
+    // stat generation 0 has no generation before it and is left at 0
+    for (int gen = this->statStartGen; gen < this->generationCount; gen++) {
+        int width = abs(this->minMaxX[gen].second - this->minMaxX[gen].first);
+        int height = abs(this->minMaxY[gen].second - this->minMaxY[gen].first);
+        this->aliveCellRatio[gen - this->statStartGen] =
+                (double) aliveCounts[gen - firstGen] / (width * height);
+        if (gen == 0)
+            continue;
+        long long int changeCount = aliveCounts[gen - 1 - firstGen]
+                + aliveCounts[gen - firstGen]
+                - 2 * commonCounts[gen - firstGen];
+        this->percentChange[gen - this->statStartGen] =
+                (double) changeCount / (width * height);
+    }
 }
 
-std::pair<int, int>
-ConwayClassifier::readWidthHeight(const std::string& secLine) const {
-    std::istringstream lineStream(secLine);
-    std::string xInfo, yInfo;
-    lineStream >> xInfo >> xInfo >> xInfo >> yInfo >> yInfo >> yInfo;
-    std::pair<int, int> WHPair(std::stoi(this->split(xInfo,
-            ",", true)), std::stoi(this->split(yInfo,
-            ",", true)));
-    return WHPair;
-}
-
-std::string ConwayClassifier::split(const std::string& str,
-        const std::string& delimiter, const bool firstStr) const {
-    auto index = str.find(delimiter);
-    if (index != std::string::npos) {
-        if (firstStr && index != 0)
-            return str.substr(0, index);
-        else if (index != str.length() - 1)
-            return str.substr(index + 1, str.length() - index - 1);
+long long int ConwayClassifier::countCommonCells(const GenerationFrame& a,
+        const GenerationFrame& b) {
+    // lay out the frame further right in the other one's words instead
+    const GenerationFrame& left = a.x <= b.x ? a : b;
+    const GenerationFrame& right = a.x <= b.x ? b : a;
+    const int rowStart = std::max(a.y, b.y);
+    const int rowEnd = std::min(a.y + a.height, b.y + b.height);
+    if (rowStart >= rowEnd || right.x >= left.x + left.width)
+        return 0;
+    const int shift = right.x - left.x;
+    // cells past the left frame's width are dead in it, so only its words
+    // are compared
+    const int wordCount = std::min(left.wordsPerRow,
+            (shift + right.width + 63) / 64);
+    long long int commonCount = 0;
+    if (shift == 0) {
+        // the rows already line up, which they do for most generations
+        for (int row = rowStart; row < rowEnd; row++) {
+            commonCount += bitkernels::popcountAnd(left.row(row - left.y),
+                    right.row(row - right.y), wordCount);
+        }
+        return commonCount;
+    }
+    std::vector<uint64_t> shifted((shift + right.width + 63) / 64);
+    for (int row = rowStart; row < rowEnd; row++) {
+        std::fill(shifted.begin(), shifted.end(), 0);
+        bitkernels::orBitsAt(shifted.data(), shift, right.row(row - right.y),
+                right.width);
+        commonCount += bitkernels::popcountAnd(left.row(row - left.y),
+                shifted.data(), wordCount);
     }
-    return "";
+    return commonCount;
 }
 
-// ToDo change logic so iterates directly through 1d gameBoard without using
-// set cell as set cell is rather inefficient (too much calculation each time
-// when you should just be increasing index by 1 for every new char read)
-
-// I don't know how much of a difference this (^^^) will make. Also, to
-// implementing this requires more that just incrementing the index for every
-// char read as the board information being read it being "set into" a board
-// of a larger size that is padded with 0's.
-
-void ConwayClassifier::fillBoard(std::vector<std::ifstream*>& dataFiles,
-        const int maxThrNum) {
-    int genWidth = this->generationCount / maxThrNum;
-    int extraWidth = this->generationCount % genWidth;
-    int lastThrStartIndex = this->generationCount - (genWidth + extraWidth);
-    std::vector<std::thread> threadList;
-    for (int i = 0; i < lastThrStartIndex; i += genWidth) {
-        threadList.push_back(std::thread(&ConwayClassifier::fillGen, this,
-                std::ref(dataFiles), i, i + genWidth - 1));
+void ConwayClassifier::fillGen(const GenerationFrame& frame, const int gen) {
+    CAGA_COUNT(this->counters.cellsSet, frame.aliveCount());
+    // a sparse board lays out every generation exactly like its frame
+    if (this->sparse) {
+        uint64_t* end = std::copy(frame.bits.begin(), frame.bits.end(),
+                this->gameBoard + this->genOffsets[gen]);
+        std::fill(end, this->gameBoard + this->genOffsets[gen + 1], 0);
+        return;
     }
-    threadList.push_back(std::thread(&ConwayClassifier::fillGen, this,
-            std::ref(dataFiles), lastThrStartIndex, this->generationCount - 1));
-    for (auto& thr : threadList) {
-        thr.join();
+    // frames are packed the same way as the board so each row can be
+    // copied over a word at a time, just shifted to its x-coord. Every
+    // generation starts on a new word so threads filling different
+    // generations never write to the same word
+    uint64_t* genWords = this->gameBoard + gen * this->wordsPerGen;
+    std::fill(genWords, genWords + this->wordsPerGen, 0);
+    for (int row = 0; row < frame.height; row++) {
+        uint64_t* boardRow = genWords
+                + (frame.y + row - this->y) * this->wordsPerRow;
+        bitkernels::orBitsAt(boardRow, frame.x - this->x, frame.row(row),
+                frame.width);
     }
 }
 
-void ConwayClassifier::fillGen(std::vector<std::ifstream*>& dataStreams,
-        const int genStartNum, const int genEndNum) {
-    int genNum = genStartNum;
-    while (genNum <= genEndNum) {
-        std::ifstream* is = dataStreams.at(genNum);
-        // get necessary info from header
-        std::string firstLine, secLine;
-        std::getline(*is, firstLine);
-        std::getline(*is, secLine); // read line to toss it out, its not needed
-        std::pair<int, int> posInfo = this->readPos(firstLine);
-        // top left coords of this gen
-        int currentX = posInfo.first;
-        int currentY = posInfo.second;
-        // read file char by char now that headers have been processed
-        char c;
-        while (is->get(c)) {
-            int repCount = 1;
-            if (std::isdigit(c)) {
-                std::string repStr = "";
-                // on last iteration through loop c becomes the char to be repeated
-                do {
-                    repStr += c;
-                    is->get(c);
-                } while (std::isdigit(c));
-                repCount = std::stoi(repStr);
-            }
-            for (int i = 0; i < repCount; i++) {
-                if (c == 'o' || c == 'b') { // live/dead cell
-                    if (c == 'o') { // set cell alive
-                        this->setCellVal(genNum, currentX,
-                                currentY, true);
-                        this->setAliveCount(genNum);
+void ConwayClassifier::finishStats(const int maxThrNum) {
+    calculateActiveCellRatio(maxThrNum);
+}
+
+void ConwayClassifier::calculateActiveCellRatio(const int maxThrNum) {
+    CAGA_TIME(this->phaseTimes.activeCellRatio);
+    // the run counters carry over from one generation to the next but every
+    // cell only depends on itself, so the board is split into bands of rows
+    // which each go through every generation with their own counters
+    const int statGenCount = this->generationCount - this->statStartGen;
+    const int bandCount = std::max(1, std::min(this->height, 4 * maxThrNum));
+    std::vector<std::vector<long long int>> bandCounts(bandCount,
+            std::vector<long long int>(statGenCount, 0));
+    parallelFor(bandCount, maxThrNum, [&](const int band) {
+        const int firstRow = (long long int) this->height * band / bandCount;
+        const int endRow = (long long int) this->height * (band + 1)
+                / bandCount;
+        const long long int firstWord = (long long int) firstRow
+                * this->wordsPerRow;
+        const long long int bandWords = (long long int) endRow
+                * this->wordsPerRow - firstWord;
+        std::vector<uint64_t> counters((runCounterBits + 1) * bandWords, 0);
+        uint64_t* planes[runCounterBits + 1];
+        for (int p = 0; p <= runCounterBits; p++) {
+            planes[p] = counters.data() + p * bandWords;
+        }
+        std::vector<uint64_t> rowWords(this->sparse ? this->wordsPerRow : 0);
+        const int runStartGen = this->getRunStartGen();
+        for (int gen = runStartGen; gen < this->generationCount; gen++) {
+            long long int activeCellCount = 0;
+            if (!this->sparse) {
+                activeCellCount = this->advanceRunCounters(
+                        this->getGenWords(gen) + firstWord, bandWords, planes,
+                        gen);
+            } else {
+                // counters are only nonzero where the cell was alive in the
+                // previous generation, so only the cells covered by this
+                // generation or the previous one need their counters moved
+                int rowStart, rowEnd, wordStart, wordEnd;
+                this->getCanvasBox(gen, std::max(runStartGen, gen - 1),
+                        rowStart, rowEnd, wordStart, wordEnd);
+                const int wordCount = wordEnd - wordStart;
+                uint64_t* rowPlanes[runCounterBits + 1];
+                for (int row = std::max(rowStart, firstRow);
+                        row < std::min(rowEnd, endRow); row++) {
+                    this->readCanvasRow(gen, row, wordStart, wordCount,
+                            rowWords.data());
+                    const long long int rowOffset = (long long int) (row
+                            - firstRow) * this->wordsPerRow + wordStart;
+                    for (int p = 0; p <= runCounterBits; p++) {
+                        rowPlanes[p] = planes[p] + rowOffset;
                     }
-                    // don't need to set cell dead as all cells initialized dead
-                    // increment currentX and currentY correctly
-                    currentX++;
-                } else if (c == '$') { // new row
-                    // set x value back to original and increment y value
-                    currentX = posInfo.first;
-                    currentY++;
+                    activeCellCount += this->advanceRunCounters(
+                            rowWords.data(), wordCount, rowPlanes, gen);
                 }
-                // else c == ! and file is over
             }
+            if (gen >= this->statStartGen)
+                bandCounts[band][gen - this->statStartGen] = activeCellCount;
         }
-        // now done with ifstream object so close it
-        is->close();
-        genNum++;
-    }
-}
-
-void ConwayClassifier::setAliveCount(const int genNum) {
-    if (genNum >= this->statStartGen)
-        this->aliveCellRatio[genNum - this->statStartGen] += 1;
-}
-
-void ConwayClassifier::finishStats() {
-    calculateAliveCellRatio();
-    calculatePercentChange();
-    calculateActiveCellRatio();
-}
-
-void ConwayClassifier::calculateAliveCellRatio() {
-    // turn counts into ratios by dividing number of alive cells by the area of
-    // the board
+    });
     for (int gen = this->statStartGen; gen < this->generationCount; gen++) {
+        long long int activeCellCount = 0;
+        for (auto& counts : bandCounts) {
+            activeCellCount += counts[gen - this->statStartGen];
+        }
         int width = abs(this->minMaxX[gen].second - this->minMaxX[gen].first);
         int height = abs(this->minMaxY[gen].second - this->minMaxY[gen].first);
-        this->aliveCellRatio[gen - this->statStartGen] =
-                this->aliveCellRatio[gen - this->statStartGen]
-                / (width * height);
+        this->activeCellRatio[gen - this->statStartGen] =
+                (double) activeCellCount / (width * height);
     }
 }
 
-void ConwayClassifier::calculatePercentChange() {
-    // since calculating stats for generation n requires the previous gen 
-    // (n - 1), need to start from statStartGen - 1 and then stop at
-    // generationCount - 2 since you would then be looking at generationCount-1
-    // and that is the maximum generation index
-    for (int gen = this->statStartGen - 1; gen <= this->generationCount - 2; gen++) {
-        int changeCount = 0;
-        for (int y = this->y; y < this->y + this->height; y++) {
-            for (int x = this->x; x < this->x + this->width; x++) {
-                if (this->getCellVal(gen, x, y) != this->getCellVal(gen + 1, x, y))
-                    changeCount++;
+int ConwayClassifier::getRunStartGen() const {
+    // a run longer than deadWithinLen is never active, so counters that can
+    // only see the last deadWithinLen + 1 gens are as good as full ones
+    return std::max(0, this->statStartGen - this->deadWithinLen);
+}
+
+long long int ConwayClassifier::advanceRunCounters(const uint64_t* genWords,
+        const long long int wordCount, uint64_t* const* planes,
+        const int gen) const {
+    // a cell is active if it is alive in gen - consecutiveAliveLen through
+    // gen and dead in at least one of gen - deadWithinLen through gen - 1
+    // (or 0 through gen - 1 this early on), so its run has to be more than
+    // consecutiveAliveLen but at most deadWithinLen long and can't go all
+    // the way back to gen 0
+    const int minRun = this->consecutiveAliveLen + 1;
+    const int maxRun = this->deadWithinLen;
+    const bool trackSinceStart = this->getRunStartGen() == 0;
+    // the words are handled a block at a time with every step being a plain
+    // loop over the words of the block, which the compiler can turn into
+    // vector instructions since the planes are contiguous arrays
+    const int blockWords = 64;
+    uint64_t carry[blockWords];
+    uint64_t atLeastMin[blockWords];
+    uint64_t atLeastMax[blockWords];
+    uint64_t equalMin[blockWords];
+    uint64_t equalMax[blockWords];
+    uint64_t active[blockWords];
+    long long int activeCellCount = 0;
+    for (long long int start = 0; start < wordCount; start += blockWords) {
+        const int count = (int) std::min<long long int>(blockWords,
+                wordCount - start);
+        const uint64_t* alive = genWords + start;
+        // add one to the counters of live cells that aren't maxed out yet,
+        // then reset the counters of dead cells
+        for (int w = 0; w < count; w++) {
+            carry[w] = ~uint64_t(0);
+        }
+        for (int p = 0; p < runCounterBits; p++) {
+            const uint64_t* plane = planes[p] + start;
+            for (int w = 0; w < count; w++) {
+                carry[w] &= plane[w];
             }
         }
-        // add one since i actually refers to gen n - 1 when calculating
-        // percent change for generation n
-        int width = abs(this->minMaxX[gen + 1].second
-                - this->minMaxX[gen + 1].first);
-        int height = abs(this->minMaxY[gen + 1].second
-                - this->minMaxY[gen + 1].first);
-        this->percentChange[gen + 1 - this->statStartGen] =
-                (double) changeCount / (width * height);
-    }
-}
-
-void ConwayClassifier::calculateActiveCellRatio() {
-    for (int gen = this->statStartGen; gen < this->generationCount; gen++) {
-        int activeCellCount = 0;
-        for (int y = this->y; y < this->y + this->height; y++) {
-            for (int x = this->x; x < this->x + this->width; x++) {
-                if (cellAliveRecently(gen, x, y) && cellDeadRecently(gen, x, y))
-                    activeCellCount++;
+        for (int w = 0; w < count; w++) {
+            carry[w] = alive[w] & ~carry[w];
+        }
+        for (int p = 0; p < runCounterBits; p++) {
+            uint64_t* plane = planes[p] + start;
+            for (int w = 0; w < count; w++) {
+                const uint64_t next = plane[w] & carry[w];
+                plane[w] = (plane[w] ^ carry[w]) & alive[w];
+                carry[w] = next;
             }
         }
-        int width = abs(this->minMaxX[gen].second - this->minMaxX[gen].first);
-        int height = abs(this->minMaxY[gen].second - this->minMaxY[gen].first);
-        this->activeCellRatio[gen - this->statStartGen] =
-                (double) activeCellCount / (width * height);
-    }
-}
-
-bool ConwayClassifier::cellAliveRecently(
-        const int gen, const int x, const int y) const {
-    // generation asked for is too early to check for being alive recently so 
-    // by given definition, this method will return false
-    if (gen < this->consecutiveAliveLen)
-        return false;
-    for (int i = gen - this->consecutiveAliveLen; i <= gen; i++) {
-        if (!this->getCellVal(i, x, y))
-            return false;
-    }
-    return true;
-}
-
-bool ConwayClassifier::cellDeadRecently(
-        const int gen, const int x, const int y) const {
-    int startGen = startGen = gen - this->deadWithinLen;
-    // just in case generation requested is less than deadWithinLen
-    if (gen < this->deadWithinLen)
-        startGen = 0;
-    for (int i = startGen; i < gen; i++) {
-        if (!this->getCellVal(i, x, y))
-            return true;
+        // compare every counter with minRun and maxRun + 1 from the top bit
+        // down, atLeast holding the counters already known to be greater
+        for (int w = 0; w < count; w++) {
+            atLeastMin[w] = 0;
+            atLeastMax[w] = 0;
+            equalMin[w] = ~uint64_t(0);
+            equalMax[w] = ~uint64_t(0);
+        }
+        for (int p = runCounterBits - 1; p >= 0; p--) {
+            const uint64_t* plane = planes[p] + start;
+            const uint64_t minBit = ((minRun >> p) & 1) ? ~uint64_t(0) : 0;
+            const uint64_t maxBit = (((maxRun + 1) >> p) & 1)
+                    ? ~uint64_t(0) : 0;
+            for (int w = 0; w < count; w++) {
+                // where the value has a 0 bit a 1 bit makes it greater, where
+                // it has a 1 bit the counter needs a 1 bit to stay equal
+                atLeastMin[w] |= equalMin[w] & plane[w] & ~minBit;
+                equalMin[w] &= ~(plane[w] ^ minBit);
+                atLeastMax[w] |= equalMax[w] & plane[w] & ~maxBit;
+                equalMax[w] &= ~(plane[w] ^ maxBit);
+            }
+        }
+        for (int w = 0; w < count; w++) {
+            active[w] = (atLeastMin[w] | equalMin[w])
+                    & ~(atLeastMax[w] | equalMax[w]);
+        }
+        if (trackSinceStart) {
+            uint64_t* sinceStart = planes[runCounterBits] + start;
+            for (int w = 0; w < count; w++) {
+                sinceStart[w] = gen == 0 ? alive[w] : sinceStart[w] & alive[w];
+                active[w] &= ~sinceStart[w];
+            }
+        }
+        activeCellCount += bitkernels::popcount(active, count);
     }
-    return false;
+    return activeCellCount;
 }
 
 long long int ConwayClassifier::get1DIndex(const int gen, const int xCoord,
@@ -399,18 +635,78 @@ long long int ConwayClassifier::get1DIndex(const int gen, const int xCoord,
     // (translation dawg)
     long long int newX = xCoord - this->x;
     long long int newY = yCoord - this->y;
-    long long int retVal = static_cast<long long> (gen *
-            static_cast<long long> (this->width * this->height))
-            + static_cast<long long> (newY * this->width) + newX;
-    if (retVal < 0 || retVal >= this->boardSize)
+    if (gen < 0 || gen >= this->generationCount || newX < 0
+            || newX >= this->width || newY < 0 || newY >= this->height)
         throw "Invalid coordinates resulting in out of bounds array index";
-    return retVal;
+    if (this->sparse) {
+        // a sparse generation only holds the cells of its own box
+        newX = xCoord - (long long int) this->minMaxX[gen].first;
+        newY = yCoord - (long long int) this->minMaxY[gen].first;
+        if (newX < 0 || xCoord >= this->minMaxX[gen].second || newY < 0
+                || yCoord >= this->minMaxY[gen].second)
+            return -1;
+        return 64 * (this->genOffsets[gen] + newY
+                * this->getGenWordsPerRow(gen)) + newX;
+    }
+    return 64 * (static_cast<long long> (gen) * this->wordsPerGen
+            + newY * this->wordsPerRow) + newX;
+}
+
+const uint64_t* ConwayClassifier::getGenWords(const int gen) const {
+    if (this->sparse)
+        return this->gameBoard + this->genOffsets[gen];
+    return this->gameBoard + static_cast<long long> (gen) * this->wordsPerGen;
+}
+
+long long int ConwayClassifier::getGenWordCount(const int gen) const {
+    if (this->sparse)
+        return this->genOffsets[gen + 1] - this->genOffsets[gen];
+    return this->wordsPerGen;
+}
+
+int ConwayClassifier::getGenWordsPerRow(const int gen) const {
+    if (this->sparse)
+        return (this->minMaxX[gen].second - this->minMaxX[gen].first + 63) / 64;
+    return this->wordsPerRow;
+}
+
+void ConwayClassifier::readCanvasRow(const int gen, const int canvasRow,
+        const int firstWord, const int wordCount, uint64_t* rowWords) const {
+    std::fill(rowWords, rowWords + wordCount, 0);
+    const int genRow = canvasRow + this->y - this->minMaxY[gen].first;
+    if (genRow < 0 || canvasRow + this->y >= this->minMaxY[gen].second)
+        return; // row is dead
+    // the first word has to be at or before the left edge of the box
+    bitkernels::orBitsAt(rowWords, this->minMaxX[gen].first - this->x
+            - 64LL * firstWord, this->getGenWords(gen)
+            + (long long int) genRow * this->getGenWordsPerRow(gen),
+            this->minMaxX[gen].second - this->minMaxX[gen].first);
+}
+
+void ConwayClassifier::getCanvasBox(const int genA, const int genB,
+        int& rowStart, int& rowEnd, int& wordStart, int& wordEnd) const {
+    rowStart = std::min(this->minMaxY[genA].first, this->minMaxY[genB].first)
+            - this->y;
+    rowEnd = std::max(this->minMaxY[genA].second, this->minMaxY[genB].second)
+            - this->y;
+    wordStart = (std::min(this->minMaxX[genA].first, this->minMaxX[genB].first)
+            - this->x) / 64;
+    wordEnd = (std::max(this->minMaxX[genA].second, this->minMaxX[genB].second)
+            - this->x + 63) / 64;
 }
 
 unsigned short int ConwayClassifier::classification() {
     return this->classNum;
 }
 
+const ConwayClassifier::PhaseTimes& ConwayClassifier::getPhaseTimes() const {
+    return this->phaseTimes;
+}
+
+const instrument::Counters& ConwayClassifier::getCounters() const {
+    return this->counters;
+}
+
 std::string ConwayClassifier::getRule() const {
     return this->rule;
 }
@@ -432,7 +728,12 @@ std::pair<int, int> ConwayClassifier::getDimensions() const {
 bool ConwayClassifier::getCellVal(const int gen, const int xCoord,
         const int yCoord) const {
     // error handling if xCoord or yCoord is less than this->x/y?
-    return this->gameBoard[this->get1DIndex(gen, xCoord, yCoord)];
+    if (this->streaming)
+        return this->window->getCellVal(gen, xCoord, yCoord);
+    long long int index = this->get1DIndex(gen, xCoord, yCoord);
+    if (index < 0) // outside of a sparse generation's box
+        return false;
+    return (this->gameBoard[index / 64] >> (index % 64)) & 1;
 }
 
 std::pair<int, int>
@@ -445,7 +746,20 @@ ConwayClassifier::getMinMax(const int gen, const bool giveXCoords) const {
 
 void ConwayClassifier::setCellVal(const int gen, const int xCoord,
         const int yCoord, const bool val) {
-    this->gameBoard[this->get1DIndex(gen, xCoord, yCoord)] = val;
+    long long int index = this->get1DIndex(gen, xCoord, yCoord);
+    if (index < 0) {
+        // cells outside of a sparse generation's box can only be dead
+        if (val)
+            throw "Cell is outside of the generation's bounding box";
+        return;
+    }
+    uint64_t mask = uint64_t(1) << (index % 64);
+    // every generation starts on a new word so threads filling different
+    // generations never write to the same word
+    if (val)
+        this->gameBoard[index / 64] |= mask;
+    else
+        this->gameBoard[index / 64] &= ~mask;
 }
 
 double ConwayClassifier::getAliveCellRatio(const int genNum) const {
@@ -482,51 +796,78 @@ double ConwayClassifier::getExpansionRateX(const int genNum) const {
     // can't get expansion rate on these gens
     if (genNum == 0 || genNum >= this->generationCount)
         return -1;
-    if (genNum == -1) { // return average
-        std::vector<double> expansionRates(this->generationCount
-                - this->statStartGen);
-        for (int i = this->statStartGen; i < this->generationCount; i++) {
-            expansionRates[i - this->statStartGen] = getExpansionRateX(i);
-        }
-        return averageVector(expansionRates);
-    }
-    return (double) (this->minMaxX[genNum].second
-            - this->minMaxX[genNum].first)
-            / (double) (this->minMaxX[genNum - 1].second
-            - this->minMaxX[genNum - 1].first);
+    this->calculateExpansionRates();
+    if (!this->expansionRatesReady)
+        return -1;
+    if (genNum == -1) // return average
+        return this->avgExpansionRateX;
+    return this->expansionRateX[genNum];
 }
 
 double ConwayClassifier::getExpansionRateY(const int genNum) const {
     // can't get expansion rate on these gens
     if (genNum == 0 || genNum >= this->generationCount)
         return -1;
-    if (genNum == -1) { // return average
-        std::vector<double> expansionRates(this->generationCount
-                - this->statStartGen);
-        for (int i = this->statStartGen; i < this->generationCount; i++) {
-            expansionRates[i - this->statStartGen] = getExpansionRateY(i);
-        }
-        return averageVector(expansionRates);
-    }
-    return (double) (this->minMaxY[genNum].second
-            - this->minMaxY[genNum].first)
-            / (double) (this->minMaxY[genNum - 1].second
-            - this->minMaxY[genNum - 1].first);
+    this->calculateExpansionRates();
+    if (!this->expansionRatesReady)
+        return -1;
+    if (genNum == -1) // return average
+        return this->avgExpansionRateY;
+    return this->expansionRateY[genNum];
 }
 
 double ConwayClassifier::getExpansionRateArea(const int genNum) const {
     // can't get expansion rate on these gens
     if (genNum == 0 || genNum >= this->generationCount)
         return -1;
-    if (genNum == -1) { // return average
-        std::vector<double> expansionRates(this->generationCount
-                - this->statStartGen);
-        for (int i = this->statStartGen; i < this->generationCount; i++) {
-            expansionRates[i - this->statStartGen] = getExpansionRateArea(i);
+    this->calculateExpansionRates();
+    if (!this->expansionRatesReady)
+        return -1;
+    if (genNum == -1) // return average
+        return this->avgExpansionRateArea;
+    return this->expansionRateArea[genNum];
+}
+
+void ConwayClassifier::calculateExpansionRates() const {
+    // the boxes are only all there once every generation has been read or
+    // pushed, and never change after that
+    if (this->expansionRatesReady
+            || (int) this->minMaxX.size() != this->generationCount)
+        return;
+    this->expansionRateX.assign(this->generationCount, -1);
+    this->expansionRateY.assign(this->generationCount, -1);
+    this->expansionRateArea.assign(this->generationCount, -1);
+    double sumX = 0;
+    double sumY = 0;
+    double sumArea = 0;
+    // the average of stat gen 0 counts its -1, as it always has
+    if (this->statStartGen == 0) {
+        sumX = sumY = sumArea = -1;
+    }
+    int prevWidth = this->minMaxX[0].second - this->minMaxX[0].first;
+    int prevHeight = this->minMaxY[0].second - this->minMaxY[0].first;
+    for (int gen = 1; gen < this->generationCount; gen++) {
+        const int width = this->minMaxX[gen].second - this->minMaxX[gen].first;
+        const int height = this->minMaxY[gen].second
+                - this->minMaxY[gen].first;
+        const double rateX = (double) width / (double) prevWidth;
+        const double rateY = (double) height / (double) prevHeight;
+        this->expansionRateX[gen] = rateX;
+        this->expansionRateY[gen] = rateY;
+        this->expansionRateArea[gen] = rateX * rateY;
+        if (gen >= this->statStartGen) {
+            sumX += rateX;
+            sumY += rateY;
+            sumArea += rateX * rateY;
         }
-        return averageVector(expansionRates);
+        prevWidth = width;
+        prevHeight = height;
     }
-    return getExpansionRateX(genNum) * getExpansionRateY(genNum);
+    const int statGenCount = this->generationCount - this->statStartGen;
+    this->avgExpansionRateX = sumX / statGenCount;
+    this->avgExpansionRateY = sumY / statGenCount;
+    this->avgExpansionRateArea = sumArea / statGenCount;
+    this->expansionRatesReady = true;
 }
 
 double
@@ -539,15 +880,31 @@ ConwayClassifier::averageVector(const std::vector<double>& statVec) const {
 }
 
 void ConwayClassifier::initializeGameBoard(const int genNum) {
+    CAGA_TIME(this->phaseTimes.allocateBoard);
     // genNum has 1 added to it because we need the initial layout in addition
     // to the specified number of generations
-    this->boardSize = static_cast<long long> (genNum + 1) *
-            static_cast<long long> (this->width) *
+    this->wordsPerRow = (this->width + 63) / 64;
+    this->wordsPerGen = static_cast<long long> (this->wordsPerRow) *
             static_cast<long long> (this->height);
-    // dynamically allocate array of given boardSize to all false
-    this->gameBoard = new bool[this->boardSize] {
-        false
-    };
+    this->boardSize = static_cast<long long> (genNum + 1) * this->wordsPerGen;
+    if (this->sparse) {
+        // every generation only takes up the words of its own box
+        this->genOffsets.assign(genNum + 2, 0);
+        for (int gen = 0; gen <= genNum; gen++) {
+            this->genOffsets[gen + 1] = this->genOffsets[gen]
+                    + static_cast<long long> (this->getGenWordsPerRow(gen))
+                    * (this->minMaxY[gen].second - this->minMaxY[gen].first);
+        }
+        this->boardSize = this->genOffsets[genNum + 1];
+    }
+    // the memory is left as it was, fillGen clears every generation's
+    // words as it fills them in
+    this->gameBoard = BoardArena::acquire(this->boardSize);
+    CAGA_COUNT(this->counters.boardBytes, this->boardSize * sizeof (uint64_t));
+    this->resizeStatVecs();
+}
+
+void ConwayClassifier::resizeStatVecs() {
     // now set this->aliveCellRatio to correct length
     this->aliveCellRatio.resize(this->generationCount - this->statStartGen);
     // set this->percentChange to correct length as well
@@ -558,19 +915,15 @@ void ConwayClassifier::initializeGameBoard(const int genNum) {
 
 void ConwayClassifier::printGameBoard(const int genNum, std::ostream& os,
         const char onChar, const char offChar) const {
-    // get index of beginning of gen by giving top 
-    // left corner coords to get1DIndex
-    int index = this->get1DIndex(genNum, this->x, this->y);
-    int genLen = this->width * this->height;
-    // go until next gen
-    for (int i = index; i < index + genLen; i++) {
-        if (this->gameBoard[i])
-            os << onChar;
-        else
-            os << offChar;
+    for (int y = this->y; y < this->y + this->height; y++) {
+        for (int x = this->x; x < this->x + this->width; x++) {
+            if (this->getCellVal(genNum, x, y))
+                os << onChar;
+            else
+                os << offChar;
+        }
         // new row
-        if ((i - (index + 1)) % this->width == 0)
-            os << std::endl;
+        os << std::endl;
     }
     os << std::endl;
 }
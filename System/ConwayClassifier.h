@@ -12,17 +12,105 @@
 #include <vector>
 #include <utility>
 #include <fstream>
+#include <functional>
+#include <unordered_map>
+#include "GenerationFrame.h"
+#include "GenerationWindow.h"
+#include "RleReader.h"
+#include "Instrumentation.h"
 
 class ConwayClassifier {
 public:
+    // wall time in seconds spent in each phase of the classification, only
+    // kept in builds with CAGA_INSTRUMENT (see Instrumentation.h). Phases
+    // that never ran (because the rule was found to be class 1 or 2 first,
+    // or in streaming mode) stay 0. Phases spread over several threads
+    // count the time until every thread is done
+    struct PhaseTimes {
+        double readGens = 0; // opening and decoding every generation
+        double class1Check = 0;
+        double class2Check = 0;
+        double boardSpecs = 0;
+        double allocateBoard = 0;
+        // filling the board, which also counts the cells the alive cell
+        // ratio and percent change come from
+        double fillBoard = 0;
+        double activeCellRatio = 0;
+        double pushGenerations = 0; // streaming mode, every pushGeneration
+    };
+
     // constructor
     // takes path to data directory and number of gens run as well as the max
-    // number of threads allowed
+    // number of threads allowed. Every .rle file is mapped and read once,
+    // and each thread only has one of them open at a time. The path can
+    // also be a generation dump (see GenerationDump.h) holding every
+    // generation in one file, which is mapped once for all the threads
     // endCalcPercent is the end percentage of generations for which stats
     // should be calculated, so endCalcPercent == 25 means that the last 
     // 25% of generations will have stats calculated for them
+    // sparseBoard keeps every generation at its own bounding box instead of
+    // the box covering every generation (see gameBoard), which uses less
+    // memory and less scanning for patterns that move or grow a lot
     ConwayClassifier(const std::string& dataDirPath, const int genNum,
-            const int maxThrNum, const int endCalcPercent);
+            const int maxThrNum, const int endCalcPercent,
+            const bool sparseBoard = false);
+
+    // constructor
+    // takes the rule (ex:b234_s67) and one stream per generation holding that
+    // generation encoded as .rle, for example streams filled from an
+    // in-process simulator instead of files written by golly. The streams
+    // are still owned by the caller and are each read once, ifstreams being
+    // closed once read. If there are fewer streams than
+    // genNum + 1 the rule is class 1, just like with missing files
+    ConwayClassifier(const std::string& rule,
+            std::vector<std::istream*>& genStreams, const int genNum,
+            const int maxThrNum, const int endCalcPercent,
+            const bool sparseBoard = false);
+
+    // constructor
+    // takes the rule (ex:b234_s67) and the generations themselves as frames
+    // (bounding box plus bit rows), for example straight from LifeSimulator,
+    // so nothing has to be encoded, written or parsed. Gives the same
+    // classification and stats as the .rle constructors would for the same
+    // generations
+    ConwayClassifier(const std::string& rule,
+            const std::vector<GenerationFrame>& frames, const int genNum,
+            const int maxThrNum, const int endCalcPercent,
+            const bool sparseBoard = false);
+
+    // constructor for streaming mode
+    // takes the rule (ex:b234_s67) but no generations. Those are handed over
+    // one at a time with pushGeneration as they are produced and the stats
+    // are calculated as they arrive. Only the last two generations and the
+    // run counters of every cell are ever kept, so memory doesn't grow with
+    // genNum.
+    // finishGenerations has to be called once there are no more generations
+    ConwayClassifier(const std::string& rule, const int genNum,
+            const int endCalcPercent);
+
+    // streaming mode only: adds the next generation, starting with gen 0
+    void pushGeneration(const GenerationFrame& frame);
+
+    // streaming mode only: returns the first generation the stats are
+    // calculated from, the ones before it only decide if the rule is
+    // class 1 or 2 and don't have to be pushed (see skipGenerations)
+    int getFirstNeededGen() const;
+
+    // streaming mode only: counts the first genCount generations as
+    // simulated without pushing them, genCount can be at most
+    // getFirstNeededGen() and nothing can have been pushed yet. Skipped
+    // generations have no bounding box (they are left out of getCoords and
+    // getDimensions) and aren't checked for repeats, so a pattern that
+    // starts repeating in them is only class 2 if it repeats again in the
+    // generations pushed
+    void skipGenerations(const int genCount);
+
+    // streaming mode only: call once every generation has been pushed. If
+    // fewer than genNum + 1 were pushed the rule is class 1, unless
+    // repeatsForever is set, which says the generations stopped early
+    // because a pattern repeated and would keep repeating without ever
+    // stopping (see SimulationEngine::getSettledClass), making it class 2
+    void finishGenerations(const bool repeatsForever = false);
 
     // destructor to deallocate
     ~ConwayClassifier();
@@ -53,6 +141,13 @@ public:
     // returns the rule of the given data as a string ex:b234_s67
     std::string getRule() const;
 
+    // returns the time spent in each phase so far
+    const PhaseTimes& getPhaseTimes() const;
+
+    // returns the bytes read, files opened, cells set and board memory
+    // allocated so far, only counted in builds with CAGA_INSTRUMENT
+    const instrument::Counters& getCounters() const;
+
     // returns the alive cell ratio for a given generation
     // if no generation is given (hence genNum = -1) then this getter will
     // return the average of all calculated alive cell ratios
@@ -77,22 +172,17 @@ public:
     // Example: if the board from one gen to the next increases in width by 50%,
     // this method would return 1.5. Conversely, if the board shrinks by 50%,
     // this method would return 0.5.
-    // NOTE: this method calculates everything as its called and thus repeat
-    // calls without a parameter (calculating the average) will reduce 
-    // performance
+    // NOTE: the expansion rates of every generation and their averages are
+    // calculated on the first call to any of these getters and kept, so
+    // repeat calls are cheap. Returns -1 until every generation has been
+    // classified
     double getExpansionRateX(const int genNum = -1) const;
     
     // same as getExpansionPercentageX but in the y-direction
-    // NOTE: this method calculates everything as its called and thus repeat
-    // calls without a parameter (calculating the average) will reduce 
-    // performance
     double getExpansionRateY(const int genNum = -1) const;
     
     // same as getExpansionPercentageX but compares total area, not just in
     // one direction
-    // NOTE: this method calculates everything as its called and thus repeat
-    // calls without a parameter (calculating the average) will reduce 
-    // performance
     double getExpansionRateArea(const int genNum = -1) const;
 
     // prints a given generation of the gameBoard to the given output stream
@@ -124,16 +214,48 @@ private:
      * that the data was "pressed" row-wise, reading down the 0th row
      * then increasing the y-coord by one and reading down the 1st row and
      * so on.
+     * The board is bit-packed, 64 cells to a word with the lowest bit being
+     * the leftmost cell. Every row starts on a new word (the bits past the
+     * width of the board are always 0) so every generation is a contiguous
+     * block of wordsPerGen words.
+     * A sparse board instead packs every generation only at its own
+     * bounding box (minMaxX and minMaxY), one generation after another
+     * starting at genOffsets[gen], rows being as many words as that
+     * generation's width needs. Cells outside of a generation's box are dead.
      */
-    bool* gameBoard; // 1d array to represent 3d board for speed
-    long long int boardSize; // size of the gameBoard array
-    const int posQualifierLen = 4; // "pos=" length in rle header
+    uint64_t* gameBoard; // 1d array to represent 3d board for speed
+    long long int boardSize; // number of words in the gameBoard array
+    int wordsPerRow; // number of words used for each row of the board
+    long long int wordsPerGen; // number of words used for each generation
+    bool sparse; // true if gameBoard is a sparse board
+    // sparse board only, word offset of every generation plus the end
+    std::vector<long long int> genOffsets;
     // saves the min and the max x-coord for every gen
     std::vector<std::pair<int, int>> minMaxX;
     // saves the min and the max y-coord for every gen
     std::vector<std::pair<int, int>> minMaxY;
     // from this gen on, stats will be calculated for things like aliveCellRatio
     int statStartGen;
+    // true if the generations are pushed one at a time and only the most
+    // recent ones are kept in the window instead of the gameBoard
+    bool streaming;
+    // streaming mode only, holds the last two generations and the run
+    // counters of every cell
+    GenerationWindow* window;
+    // streaming mode only, number of generations pushed so far
+    int pushedGenCount;
+    // streaming mode only, number of generations skipped before the first
+    // one pushed
+    int skippedGenCount;
+    // streaming mode only, every generation pushed until one repeats, to
+    // check for class 2
+    ShapeHistory seenShapes;
+    // streaming mode only, true once some pattern has been pushed twice
+    bool patternRepeated;
+    // time spent in each phase so far
+    PhaseTimes phaseTimes;
+    // work done so far
+    instrument::Counters counters;
     // vector describing alive cell ratio for gens specified by endCalcPercent
     std::vector<double> aliveCellRatio;
     // vector where each element describes
@@ -146,18 +268,52 @@ private:
     // alive for the last n generations, and also have been dead within the
     // last k generations
     std::vector<double> activeCellRatio;
+    // expansion rate of every generation from the previous one along the
+    // x-axis, the y-axis and in area, element 0 being -1 since gen 0 has no
+    // previous gen. Only filled in once one of the getters asks for them
+    mutable std::vector<double> expansionRateX;
+    mutable std::vector<double> expansionRateY;
+    mutable std::vector<double> expansionRateArea;
+    // averages of the expansion rates over the stat generations
+    mutable double avgExpansionRateX;
+    mutable double avgExpansionRateY;
+    mutable double avgExpansionRateArea;
+    // true once the expansion rates have been calculated
+    mutable bool expansionRatesReady;
     // describes how many immediately previous consecutive generations a cell
     // must be alive to fulfill that part of the "active cell" requirement
-    // Used by the cellAliveRecently method
-    // For example, if this constant is set to 5, the cellAliveRecently method
-    // checks the 5 previous gens and the current gen, so 6 in total
+    // For example, if this constant is set to 5, a cell has to be alive in
+    // the 5 previous gens and the current gen, so 6 in total
     const int consecutiveAliveLen = 5;
     // describes the range of immediately previous generations within which
     // a cell must be dead for at least one of those generations to fulfill this
     // part of the "active cell" requirement
-    // Used by the cellDeadRecently method
     const int deadWithinLen = 25;
-
+    // number of bits of the per-cell run counters used to find active cells,
+    // which count up to 2^runCounterBits - 1 and then stay there. Has to be
+    // able to count past deadWithinLen
+    static const int runCounterBits = 5;
+
+
+    // sets up the statStartGen and generationCount instance variables, and
+    // the streaming mode ones as if streaming mode is not used
+    void initializeGenCounts(const int genNum, const int endCalcPercent);
+
+    // reads every generation once, in parallel on maxThrNum threads: readGen
+    // is called with each generation number and has to decode that
+    // generation into the given frame. The shape hash of every frame is
+    // worked out in the same pass
+    void readGens(const int maxThrNum,
+            const std::function<void(const int, GenerationFrame&)>& readGen,
+            std::vector<GenerationFrame>& frames,
+            std::vector<uint64_t>& hashes);
+
+    // runs the class 2 check on the frames and if needed goes on to build
+    // the board from them and calculate the stats. hashes holds the shape
+    // hash of every frame
+    void classifyFrames(const std::vector<GenerationFrame>& frames,
+            const std::vector<uint64_t>& hashes, const int genNum,
+            const int maxThrNum);
 
     // this is used to set relevant instance variables to 0/null if
     // class is determined to be 1/2 before classification method is called
@@ -172,95 +328,124 @@ private:
     // variable to 1.
     void checkForClass1(const std::string& dataDirPath, const int genNum);
 
-    // adds encoded pattern in each rle file to hash map to check for repeat
-    // patterns. If it is class 2, the classNum variable will be set to 2
-    void checkForClass2(std::vector<std::ifstream*>& dataFiles);
-
-    // takes vector of ifstream objects to figure out coords and dimensions
-    // when finished resets ifstreams
-    // sets the x, y, width and height vars and dynamically resizes gameBoard
-    void calcBoardSpecs(std::vector<std::ifstream*>& dataFiles);
-
-    // with the board specs calculated fill gameBoard array with data from files
-    // by calling fillGen for every ifstream
-    void fillBoard(std::vector<std::ifstream*>& dataFiles, const int maxThrNum);
-
-    // reads files corresponding to genStartNum through (and including) 
-    // genEndNum and fills the gameBoard accordingly. Once done with a given
-    // ifstream object it closes it.
-    void fillGen(std::vector<std::ifstream*>& dataStreams,
-            const int genStartNum, const int genEndNum);
-
-    // takes path to the data directory and creates ifstream object for every
-    // file and adds its address (pointer) to a vector; then returns that vector
-    std::vector<std::ifstream*> populateIStreamVec(const std::string& dataPath,
-            const int genNum) const;
-
-    // deallocate all the ifstreams that are allocated in the populateIstreamVec
-    // method
-    void deallocateIfstreams(std::vector<std::ifstream*>& streamsToClose) const;
-
-    // splits a string based on the given delimiter, returns the before the
-    // delimiter if firstStr parameter is true, returns after the delimiter
-    // if firstStr is false
-    // returns empty string if no split can be made
-    // used to help parse .rle headers 
-    std::string split(const std::string& str, const std::string& delimiter,
-            const bool firstStr) const;
+    // adds the shape hash of each generation to a hash map to check for
+    // repeat patterns, comparing the frames themselves only when two hashes
+    // are the same. The shape of a frame is the same thing as the encoded
+    // pattern of its rle file. If it is class 2, the classNum variable will
+    // be set to 2
+    void checkForClass2(const std::vector<GenerationFrame>& frames,
+            const std::vector<uint64_t>& hashes);
+
+    // takes the bounding box of each frame to figure out coords and
+    // dimensions, sets the x, y, width and height vars
+    void calcBoardSpecs(const std::vector<GenerationFrame>& frames);
+
+    // adds the bounding box of the next generation to minMaxX and minMaxY
+    void addGenSpecs(const int genX, const int genY, const int genWidth,
+            const int genHeight);
+
+    // sets the x, y, width and height vars to cover every generation that
+    // has been added to minMaxX and minMaxY
+    void setBoardSpecs();
+
+    // with the board specs calculated fill gameBoard array by copying the
+    // live cells of every frame. The aliveCellRatio and percentChange of
+    // the stat generations are worked out from the frames in the same pass,
+    // so neither needs a pass over the board of its own
+    void fillBoard(const std::vector<GenerationFrame>& frames,
+            const int maxThrNum);
+
+    // returns the number of cells alive in both a and b, only looking at
+    // the rows and words the two frames share
+    static long long int countCommonCells(const GenerationFrame& a,
+            const GenerationFrame& b);
+
+    // copies a frame into the given generation of the gameBoard
+    void fillGen(const GenerationFrame& frame, const int gen);
+
+    // returns the path of the .rle file of the given generation
+    std::string getGenPath(const std::string& dataPath, const int gen) const;
 
     // takes what would be the 3 values needed to get a value of a cell in 
-    // Conway's game and calculates at what 1D index that cell data is stored
-    // in the gameBoard instance variable
+    // Conway's game and calculates at what 1D bit index that cell data is
+    // stored in the gameBoard instance variable (word index / 64, bit % 64)
+    // or -1 if the cell is outside of a sparse generation's box (so dead)
     long long int get1DIndex(const int gen, const int xCoord,
             const int yCoord) const;
 
+    // returns pointer to the first word of the given generation
+    const uint64_t* getGenWords(const int gen) const;
+
     // sets a given cell to a given value
     void setCellVal(const int gen, const int xCoord, const int yCoord,
             const bool val);
 
-    // allocates memory for the gameBoard instance var and sets every elt to 0
-    // also sets aliveCellRatio vector to correct length
-    void initializeGameBoard(const int genNum);
+    // returns number of words the given generation takes up
+    long long int getGenWordCount(const int gen) const;
 
-    // takes the first line of an rle file and extracts the x and y values
-    // for the position of the upper right corner of the data
-    // return the x and y values as pair in that order
-    std::pair<int, int> readPos(const std::string& firstLine) const;
+    // returns number of words in each row of the given generation
+    int getGenWordsPerRow(const int gen) const;
 
-    // takes the second line of an rle file as a string and extracts the 
-    // width and height data ("x =" and "y =" in the rle) and returns
-    // the data as a pair
-    std::pair<int, int> readWidthHeight(const std::string& secLine) const;
+    // sparse board only: lays out the cells of canvas row canvasRow of the
+    // given generation on words firstWord through firstWord + wordCount - 1
+    // of a row of the full board (the box covering every generation)
+    void readCanvasRow(const int gen, const int canvasRow,
+            const int firstWord, const int wordCount, uint64_t* rowWords) const;
 
-    // adds 1 to correct vector element of aliveCellRatio
-    void setAliveCount(const int genNum);
+    // sparse board only: finds the words of the full board covered by the
+    // bounding boxes of genA and genB, as rows [rowStart, rowEnd) and words
+    // [wordStart, wordEnd) of each row
+    void getCanvasBox(const int genA, const int genB, int& rowStart,
+            int& rowEnd, int& wordStart, int& wordEnd) const;
 
-    // finishes calculating stats like the aliveCellRatio by dividing each
-    // generation's alive count by the area of the generation
-    void finishStats();
-    
-    // calculates the alive cell ratio from each element in the vector by 
-    // dividing each vector element by the area of the gameBoard
-    void calculateAliveCellRatio();
+    // takes memory for the gameBoard instance var from this thread's
+    // BoardArena without clearing it, fillGen clears every generation's
+    // words. Also sets aliveCellRatio vector to correct length
+    void initializeGameBoard(const int genNum);
+
+    // sets aliveCellRatio, percentChange and activeCellRatio to the number
+    // of generations that stats will be calculated for
+    void resizeStatVecs();
 
-    // goes through generations specified by endCalcPercent and calculates
-    // the percent change of cells between generations
-    void calculatePercentChange();
+    // finishes calculating the stats once the board is filled, which only
+    // leaves the activeCellRatio since fillBoard works out the others.
+    // Spread over up to maxThrNum threads
+    void finishStats(const int maxThrNum);
     
+    // calculates the expansion rates of every generation and their averages
+    // in one pass over minMaxX and minMaxY, if every generation's bounding
+    // box is known and they haven't been calculated yet
+    void calculateExpansionRates() const;
+
     // calculates the active cell ratio for all necessary generations and
-    // populates the activeCellRatio vector as it does so.
-    void calculateActiveCellRatio();
+    // populates the activeCellRatio vector as it does so. The board is
+    // split into bands of rows that keep their own run counters
+    void calculateActiveCellRatio(const int maxThrNum);
     
+    // streaming mode only: calculates the alive cell ratio and percent
+    // change of the given generation from the generations kept in the window
+    // and stores activeCellCount as its active cell ratio
+    void calcStreamingStats(const int gen,
+            const long long int activeCellCount);
+
+    // returns first generation the run counters have to see so the active
+    // cells of statStartGen onwards come out right
+    int getRunStartGen() const;
+
+    // adds a generation to the run counters and returns how many of its
+    // cells are active. Every cell has a counter of how many generations in
+    // a row through gen it has been alive, stored bit-sliced over
+    // runCounterBits planes of wordCount words laid out like genWords
+    // (plane p holds bit p of every counter). Plane runCounterBits holds
+    // whether the cell has been alive since gen 0, which is only needed
+    // while there aren't deadWithinLen generations before gen yet.
+    // Generations have to be added in order starting with getRunStartGen
+    long long int advanceRunCounters(const uint64_t* genWords,
+            const long long int wordCount, uint64_t* const* planes,
+            const int gen) const;
+
     // takes a vector of doubles and returns the average of those values
     double averageVector(const std::vector<double>& statVec) const;
-    
-    // says whether or not a cell has been alive for n immediately previous
-    // generations (n = this->consecutiveAliveLen)
-    bool cellAliveRecently(const int gen, const int x, const int y) const;
-    
-    // says whether or not a cell has been dead for at least one of the
-    // immediately previous n generations (n = this->deadWithinLen)
-    bool cellDeadRecently(const int gen, const int x, const int y) const;
 };
 
 
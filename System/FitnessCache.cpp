@@ -0,0 +1,179 @@
+#ifndef FITNESS_CACHE_CPP
+#define FITNESS_CACHE_CPP
+
+/*
+ * File:   FitnessCache.cpp
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include "FitnessCache.h"
+
+// every cache file starts with these bytes
+static const char CACHE_MAGIC[8] = {'C', 'A', 'G', 'A', 'F', 'C', '0', '1'};
+
+FitnessCache::FitnessCache(const std::string& paramsKey,
+        const std::string& fileName) {
+    this->paramsKey = paramsKey;
+    this->fileName = fileName;
+    this->changed = false;
+    if (fileName != "")
+        this->load();
+}
+
+bool FitnessCache::lookup(const std::string& chromosome,
+        RuleMetrics& metrics, const int soup) {
+    return this->lookup(packChromosome(chromosome), metrics, soup);
+}
+
+bool FitnessCache::lookup(const uint32_t packed, RuleMetrics& metrics,
+        const int soup) {
+    const std::string key = this->soupKey(soup);
+    std::lock_guard<std::mutex> guard(this->lock);
+    auto& run = this->entries[key];
+    auto entry = run.find(packed);
+    if (entry == std::end(run))
+        return false;
+    metrics = entry->second;
+    return true;
+}
+
+void FitnessCache::store(const std::string& chromosome,
+        const RuleMetrics& metrics, const int soup) {
+    this->store(packChromosome(chromosome), metrics, soup);
+}
+
+void FitnessCache::store(const uint32_t packed, const RuleMetrics& metrics,
+        const int soup) {
+    const std::string key = this->soupKey(soup);
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->entries[key][packed] = metrics;
+    this->changed = true;
+}
+
+std::string FitnessCache::soupKey(const int soup) const {
+    // soup 0 keeps the plain key so caches from before soups still match
+    if (soup == 0)
+        return this->paramsKey;
+    return this->paramsKey + ";soup=" + std::to_string(soup);
+}
+
+int FitnessCache::size() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return (int) this->entries[this->paramsKey].size();
+}
+
+uint32_t FitnessCache::packChromosome(const std::string& chromosome) {
+    uint32_t packed = 0;
+    for (size_t i = 0; i < chromosome.length(); i++) {
+        if (chromosome[i] == '1')
+            packed |= uint32_t(1) << i;
+    }
+    return packed;
+}
+
+// the file is a list of parameter sets, each one being
+// uint32 key length, key, uint32 entry count, then for every entry
+// uint32 packed chromosome, 3 doubles of metrics and uint16 classNum
+void FitnessCache::load() {
+    std::ifstream in(this->fileName, std::ios::binary);
+    if (!in.is_open())
+        return; // nothing saved yet
+    char magic[sizeof (CACHE_MAGIC)];
+    if (!in.read(magic, sizeof (magic))
+            || !std::equal(magic, magic + sizeof (magic), CACHE_MAGIC))
+        throw "Fitness cache file is not a cache file";
+    this->readEntries(in);
+}
+
+void FitnessCache::readEntries(std::istream& in) {
+    uint32_t keyLen;
+    while (in.read(reinterpret_cast<char*> (&keyLen), sizeof (keyLen))) {
+        std::string key(keyLen, '\0');
+        uint32_t count;
+        in.read(&key[0], keyLen);
+        in.read(reinterpret_cast<char*> (&count), sizeof (count));
+        auto& run = this->entries[key];
+        for (uint32_t i = 0; i < count && in; i++) {
+            uint32_t packed;
+            RuleMetrics metrics;
+            in.read(reinterpret_cast<char*> (&packed), sizeof (packed));
+            in.read(reinterpret_cast<char*> (&metrics.aliveCell),
+                    sizeof (double));
+            in.read(reinterpret_cast<char*> (&metrics.percentChange),
+                    sizeof (double));
+            in.read(reinterpret_cast<char*> (&metrics.activeCell),
+                    sizeof (double));
+            in.read(reinterpret_cast<char*> (&metrics.classNum),
+                    sizeof (metrics.classNum));
+            if (in)
+                run[packed] = metrics;
+        }
+        if (!in)
+            throw "Fitness cache file is truncated";
+    }
+}
+
+void FitnessCache::save() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (this->fileName == "" || !this->changed)
+        return;
+    // write next to the real file and rename it over, which is atomic
+    std::string tempName = this->fileName + ".tmp";
+    {
+        std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            throw "Could not write the fitness cache file";
+        out.write(CACHE_MAGIC, sizeof (CACHE_MAGIC));
+        this->writeEntries(out, false);
+        if (!out)
+            throw "Could not write the fitness cache file";
+    }
+    if (std::rename(tempName.c_str(), this->fileName.c_str()) != 0)
+        throw "Could not replace the fitness cache file";
+    this->changed = false;
+}
+
+void FitnessCache::writeEntries(std::ostream& out, const bool thisRunOnly) {
+    const std::string soupPrefix = this->paramsKey + ";soup=";
+    for (auto& run : this->entries) {
+        if (thisRunOnly && run.first != this->paramsKey
+                && run.first.compare(0, soupPrefix.length(), soupPrefix) != 0)
+            continue;
+        uint32_t keyLen = run.first.length();
+        uint32_t count = run.second.size();
+        out.write(reinterpret_cast<const char*> (&keyLen), sizeof (keyLen));
+        out.write(run.first.data(), keyLen);
+        out.write(reinterpret_cast<const char*> (&count), sizeof (count));
+        for (auto& entry : run.second) {
+            const RuleMetrics& metrics = entry.second;
+            out.write(reinterpret_cast<const char*> (&entry.first),
+                    sizeof (entry.first));
+            out.write(reinterpret_cast<const char*> (&metrics.aliveCell),
+                    sizeof (double));
+            out.write(reinterpret_cast<const char*> (&metrics.percentChange),
+                    sizeof (double));
+            out.write(reinterpret_cast<const char*> (&metrics.activeCell),
+                    sizeof (double));
+            out.write(reinterpret_cast<const char*> (&metrics.classNum),
+                    sizeof (metrics.classNum));
+        }
+    }
+}
+
+void FitnessCache::saveTo(std::ostream& out) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->writeEntries(out, true);
+}
+
+void FitnessCache::loadFrom(std::istream& in) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->readEntries(in);
+    this->changed = true;
+}
+
+#endif /* FITNESS_CACHE_CPP */
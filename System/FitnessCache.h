@@ -0,0 +1,94 @@
+/*
+ * File:   FitnessCache.h
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#ifndef FITNESS_CACHE_H
+#define FITNESS_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <map>
+#include <mutex>
+
+// the stats the ConwayClassifier works out for a rule. The fitness itself is
+// not kept since it depends on the weights and ideal metrics, which are
+// exactly what a parameter sweep changes
+struct RuleMetrics {
+    double aliveCell;
+    double percentChange;
+    double activeCell;
+    unsigned short int classNum;
+};
+
+// Remembers the RuleMetrics of every rule that has been simulated so rules
+// that come up again (elitism, duplicates) skip the simulation and the
+// classifier. Entries are keyed by the chromosome and a string describing
+// the simulation parameters (seed, grid, time elapsed, ...) since metrics
+// found with other parameters don't carry over. Can be saved to and loaded
+// from a file, which may hold entries for any number of parameter sets.
+// A rule scored on several soups has an entry for each, soup 0 being the
+// one paramsKey describes and soup k the one seeded k after it.
+// Safe to use from several threads at once
+class FitnessCache {
+public:
+    // constructor
+    // paramsKey describes the simulation parameters of this run, fileName is
+    // the file to load from and save to, "" keeps the cache in memory only
+    FitnessCache(const std::string& paramsKey, const std::string& fileName);
+
+    // true if the metrics of the chromosome on the given soup are known,
+    // copying them to metrics if so. The chromosome is either a string or
+    // packed the way packChromosome packs it
+    bool lookup(const std::string& chromosome, RuleMetrics& metrics,
+            const int soup = 0);
+    bool lookup(const uint32_t packed, RuleMetrics& metrics,
+            const int soup = 0);
+
+    // adds the metrics of a chromosome on the given soup
+    void store(const std::string& chromosome, const RuleMetrics& metrics,
+            const int soup = 0);
+    void store(const uint32_t packed, const RuleMetrics& metrics,
+            const int soup = 0);
+
+    // writes every entry to the file (if there is one). The file is replaced
+    // in one go so a crash never leaves a half written cache behind
+    void save();
+
+    // writes the entries of this run (every soup) to out and adds entries
+    // written that way back in, for files that hold a cache in them
+    void saveTo(std::ostream& out);
+    void loadFrom(std::istream& in);
+
+    // returns number of entries for the parameters of this run, counting
+    // the rules scored on soup 0
+    int size();
+
+    // turns a chromosome of '0's and '1's into a number, gene i is bit i
+    static uint32_t packChromosome(const std::string& chromosome);
+
+private:
+    std::string paramsKey;
+    std::string fileName;
+    std::mutex lock;
+    // paramsKey -> packed chromosome -> metrics
+    std::map<std::string, std::unordered_map<uint32_t, RuleMetrics>> entries;
+    bool changed; // true if there are entries the file doesn't have yet
+
+    // returns the key the entries of the given soup are under
+    std::string soupKey(const int soup) const;
+
+    // reads every entry in the file, throws if it isn't a cache file
+    void load();
+
+    // the file's entries after its magic, read until in runs out. Only this
+    // run's are written with thisRunOnly. The caller holds the lock
+    void readEntries(std::istream& in);
+    void writeEntries(std::ostream& out, const bool thisRunOnly);
+};
+
+#endif /* FITNESS_CACHE_H */
@@ -0,0 +1,215 @@
+#ifndef GENERATION_DUMP_CPP
+#define GENERATION_DUMP_CPP
+
+/*
+ * File:   GenerationDump.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef CAGA_WITH_ZLIB
+#include <zlib.h>
+#endif
+#include "GenerationDump.h"
+
+const char generationdump::magic[8] = {'C', 'A', 'G', 'A', 'G', 'D', '0', '1'};
+
+GenerationDumpWriter::GenerationDumpWriter(const std::string& path,
+        const std::string& rule, const bool compress) {
+    this->path = path;
+    this->tempPath = path + ".tmp";
+    this->compress = compress;
+    this->closed = false;
+    this->offset = 0;
+    this->out.open(this->tempPath, std::ios::binary | std::ios::trunc);
+    if (!this->out.is_open())
+        throw "Could not create generation dump";
+    // the rule length is the only part of the header known up front, the
+    // rest is filled in once the index is written
+    char header[generationdump::headerSize] = {};
+    uint32_t ruleLen = rule.length();
+    std::memcpy(header + 24, &ruleLen, sizeof (ruleLen));
+    this->put(header, sizeof (header));
+    this->put(rule.data(), rule.length());
+}
+
+GenerationDumpWriter::~GenerationDumpWriter() {
+    if (!this->closed) {
+        this->out.close();
+        std::remove(this->tempPath.c_str());
+    }
+}
+
+void GenerationDumpWriter::put(const void* data, const size_t count) {
+    this->out.write(static_cast<const char*> (data), count);
+    this->offset += count;
+}
+
+void GenerationDumpWriter::align() {
+    static const char zeros[8] = {};
+    this->put(zeros, (8 - this->offset % 8) % 8);
+}
+
+void GenerationDumpWriter::write(const GenerationFrame& frame) {
+    if (this->closed)
+        throw "Generation dump is already closed";
+    this->align();
+    const uint64_t frameOffset = this->offset;
+    const char* bytes = reinterpret_cast<const char*> (frame.bits.data());
+    uint32_t storedBytes = frame.bits.size() * sizeof (uint64_t);
+    uint32_t compressed = 0;
+#ifdef CAGA_WITH_ZLIB
+    if (this->compress && storedBytes > 0) {
+        // frames are compressed on their own so any one can be decoded
+        // without the others, level 1 since most frames are read only once
+        std::vector<Bytef> packed(compressBound(storedBytes));
+        uLongf packedBytes = packed.size();
+        if (compress2(packed.data(), &packedBytes,
+                reinterpret_cast<const Bytef*> (bytes), storedBytes, 1) == Z_OK
+                && packedBytes < storedBytes) {
+            this->put(packed.data(), packedBytes);
+            storedBytes = packedBytes;
+            compressed = 1;
+        }
+    }
+#endif
+    if (compressed == 0)
+        this->put(bytes, storedBytes);
+    int32_t box[4] = {frame.x, frame.y, frame.width, frame.height};
+    char entry[generationdump::indexEntrySize];
+    std::memcpy(entry, box, sizeof (box));
+    std::memcpy(entry + 16, &frameOffset, sizeof (frameOffset));
+    std::memcpy(entry + 24, &storedBytes, sizeof (storedBytes));
+    std::memcpy(entry + 28, &compressed, sizeof (compressed));
+    this->index.insert(this->index.end(), entry, entry + sizeof (entry));
+}
+
+void GenerationDumpWriter::close() {
+    if (this->closed)
+        return;
+    this->align();
+    const uint64_t indexOffset = this->offset;
+    this->put(this->index.data(), this->index.size());
+    int32_t genCount = this->index.size() / generationdump::indexEntrySize;
+    this->out.seekp(0);
+    this->out.write(generationdump::magic, sizeof (generationdump::magic));
+    this->out.seekp(12);
+    this->out.write(reinterpret_cast<const char*> (&genCount),
+            sizeof (genCount));
+    this->out.write(reinterpret_cast<const char*> (&indexOffset),
+            sizeof (indexOffset));
+    this->out.close();
+    if (!this->out)
+        throw "Could not write generation dump";
+    // moving it into place is atomic, so readers never see half a dump
+    if (std::rename(this->tempPath.c_str(), this->path.c_str()) != 0)
+        throw "Could not write generation dump";
+    this->closed = true;
+}
+
+GenerationDumpReader::GenerationDumpReader(const std::string& path) {
+    this->data = nullptr;
+    this->length = 0;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw "Could not open generation dump";
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size >= generationdump::headerSize) {
+        void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            this->data = static_cast<const char*> (map);
+            this->length = info.st_size;
+        }
+    }
+    // the mapping stays valid without the file descriptor
+    close(fd);
+    if (this->data == nullptr)
+        throw "Could not map generation dump";
+    // every frame is going to be read, so start paging it in
+    madvise(const_cast<char*> (this->data), this->length, MADV_WILLNEED);
+    const uint32_t ruleLen = this->readAt<uint32_t>(24);
+    const uint64_t indexOffset = this->readAt<uint64_t>(16);
+    this->genCount = this->readAt<int32_t>(12);
+    if (!std::equal(this->data, this->data + sizeof (generationdump::magic),
+            generationdump::magic) || this->genCount < 0
+            || generationdump::headerSize + ruleLen > this->length
+            || indexOffset > this->length
+            || (this->length - indexOffset) / generationdump::indexEntrySize
+                < (uint64_t) this->genCount) {
+        munmap(const_cast<char*> (this->data), this->length);
+        throw "File is not a complete generation dump";
+    }
+    this->rule.assign(this->data + generationdump::headerSize, ruleLen);
+    this->index = this->data + indexOffset;
+}
+
+GenerationDumpReader::~GenerationDumpReader() {
+    munmap(const_cast<char*> (this->data), this->length);
+}
+
+template<typename T>
+T GenerationDumpReader::readAt(const uint64_t at) const {
+    // the mapping is only read through memcpy so nothing has to be aligned
+    T value;
+    std::memcpy(&value, this->data + at, sizeof (T));
+    return value;
+}
+
+std::string GenerationDumpReader::getRule() const {
+    return this->rule;
+}
+
+int GenerationDumpReader::getGenCount() const {
+    return this->genCount;
+}
+
+size_t GenerationDumpReader::getLength() const {
+    return this->length;
+}
+
+void GenerationDumpReader::decodeFrame(const int gen,
+        GenerationFrame& frame) const {
+    if (gen < 0 || gen >= this->genCount)
+        throw "Generation is not in the dump";
+    const uint64_t entry = (this->index - this->data)
+            + (uint64_t) gen * generationdump::indexEntrySize;
+    const int32_t x = this->readAt<int32_t>(entry);
+    const int32_t y = this->readAt<int32_t>(entry + 4);
+    const int32_t width = this->readAt<int32_t>(entry + 8);
+    const int32_t height = this->readAt<int32_t>(entry + 12);
+    const uint64_t frameOffset = this->readAt<uint64_t>(entry + 16);
+    const uint32_t storedBytes = this->readAt<uint32_t>(entry + 24);
+    const uint32_t compressed = this->readAt<uint32_t>(entry + 28);
+    if (width < 0 || height < 0 || frameOffset > this->length
+            || storedBytes > this->length - frameOffset)
+        throw "Generation dump is corrupt";
+    frame.resize(x, y, width, height);
+    const size_t frameBytes = frame.bits.size() * sizeof (uint64_t);
+    const char* stored = this->data + frameOffset;
+    if (compressed == 0) {
+        if (storedBytes != frameBytes)
+            throw "Generation dump is corrupt";
+        std::memcpy(frame.bits.data(), stored, frameBytes);
+        return;
+    }
+#ifdef CAGA_WITH_ZLIB
+    uLongf unpackedBytes = frameBytes;
+    if (uncompress(reinterpret_cast<Bytef*> (frame.bits.data()),
+            &unpackedBytes, reinterpret_cast<const Bytef*> (stored),
+            storedBytes) != Z_OK || unpackedBytes != frameBytes)
+        throw "Generation dump is corrupt";
+#else
+    throw "Compressed generation dumps need a build with CAGA_WITH_ZLIB";
+#endif
+}
+
+#endif /* GENERATION_DUMP_CPP */
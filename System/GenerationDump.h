@@ -0,0 +1,121 @@
+/*
+ * File:   GenerationDump.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef GENERATION_DUMP_H
+#define GENERATION_DUMP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "GenerationFrame.h"
+
+// A generation dump holds every generation of one rule in a single file
+// instead of a .rle file per generation. golly-script.py writes them with
+// GenerationFormat set to Dump, GenerationDumpWriter from C++. Everything
+// is little-endian:
+//   header     8 byte magic "CAGAGD01", uint32 flags (0), int32 number of
+//              generations, uint64 offset of the index, uint32 length of
+//              the rule, uint32 0, then the rule (ex:b234_s67)
+//   frames     the cells of every generation at its own bounding box, bit
+//              packed the same way as a GenerationFrame's bits and starting
+//              on an 8 byte boundary, each one either stored as is or
+//              compressed with zlib
+//   index      one entry per generation: int32 x, y, width and height of
+//              the box, uint64 offset of the frame, uint32 bytes stored and
+//              uint32 1 if the frame is compressed, 0 if not
+// The writer puts the index and the final header in last and renames the
+// file into place, so a dump that exists is always complete.
+namespace generationdump {
+    // every dump starts with these bytes
+    extern const char magic[8];
+
+    // size of the fixed part of the header and of an index entry
+    const int headerSize = 32;
+    const int indexEntrySize = 32;
+}
+
+class GenerationDumpWriter {
+public:
+    // constructor
+    // starts the dump of the rule (ex:b234_s67) at path, compressing frames
+    // if compress is set and that makes them smaller. Compression needs a
+    // build with CAGA_WITH_ZLIB, without it every frame is stored as is.
+    // Throws if the file can't be created
+    GenerationDumpWriter(const std::string& path, const std::string& rule,
+            const bool compress);
+
+    // removes the unfinished dump if close was never called
+    ~GenerationDumpWriter();
+
+    GenerationDumpWriter(const GenerationDumpWriter&) = delete;
+    GenerationDumpWriter& operator=(const GenerationDumpWriter&) = delete;
+
+    // adds the next generation, starting with gen 0
+    void write(const GenerationFrame& frame);
+
+    // writes the index and the header and moves the dump to its path
+    void close();
+
+private:
+    std::string path;
+    std::string tempPath;
+    std::ofstream out;
+    bool compress;
+    bool closed;
+    uint64_t offset; // bytes written so far
+    std::vector<char> index;
+
+    // writes count bytes and keeps track of the offset
+    void put(const void* data, const size_t count);
+
+    // pads the file with zeros up to the next 8 byte boundary
+    void align();
+};
+
+// Maps a generation dump and decodes its frames. The mapping is read only
+// and every frame is decoded on its own, so several threads may decode
+// frames of the same reader at once.
+class GenerationDumpReader {
+public:
+    // maps the dump at path, throws if it can't be opened or isn't a
+    // complete generation dump
+    explicit GenerationDumpReader(const std::string& path);
+
+    // unmaps the file
+    ~GenerationDumpReader();
+
+    GenerationDumpReader(const GenerationDumpReader&) = delete;
+    GenerationDumpReader& operator=(const GenerationDumpReader&) = delete;
+
+    // returns the rule of the dump ex:b234_s67
+    std::string getRule() const;
+
+    // returns the number of generations in the dump
+    int getGenCount() const;
+
+    // returns the size of the dump in bytes
+    size_t getLength() const;
+
+    // resizes the frame to the box of the given generation and decodes the
+    // generation into it. Throws if the frame is compressed and the build
+    // has no CAGA_WITH_ZLIB
+    void decodeFrame(const int gen, GenerationFrame& frame) const;
+
+private:
+    const char* data;
+    size_t length;
+    std::string rule;
+    int genCount;
+    const char* index;
+
+    // reads a value of type T at the given byte offset of the mapping
+    template<typename T>
+    T readAt(const uint64_t at) const;
+};
+
+#endif /* GENERATION_DUMP_H */
@@ -0,0 +1,154 @@
+#ifndef GENERATION_FRAME_CPP
+#define GENERATION_FRAME_CPP
+
+/*
+ * File:   GenerationFrame.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include "GenerationFrame.h"
+
+void GenerationFrame::resize(const int xCoord, const int yCoord,
+        const int frameWidth, const int frameHeight) {
+    this->x = xCoord;
+    this->y = yCoord;
+    this->width = frameWidth;
+    this->height = frameHeight;
+    this->wordsPerRow = (frameWidth + 63) / 64;
+    this->bits.assign(static_cast<size_t> (this->wordsPerRow) *
+            static_cast<size_t> (frameHeight), 0);
+}
+
+bool GenerationFrame::empty() const {
+    return this->width == 0 || this->height == 0;
+}
+
+const uint64_t* GenerationFrame::row(const int rowNum) const {
+    return this->bits.data() + static_cast<size_t> (rowNum) * this->wordsPerRow;
+}
+
+uint64_t* GenerationFrame::row(const int rowNum) {
+    return this->bits.data() + static_cast<size_t> (rowNum) * this->wordsPerRow;
+}
+
+bool GenerationFrame::getCellVal(const int xCoord, const int yCoord) const {
+    int relX = xCoord - this->x;
+    int relY = yCoord - this->y;
+    if (relX < 0 || relY < 0 || relX >= this->width || relY >= this->height)
+        return false;
+    return (this->row(relY)[relX / 64] >> (relX % 64)) & 1;
+}
+
+void GenerationFrame::setCellVal(const int xCoord, const int yCoord,
+        const bool val) {
+    int relX = xCoord - this->x;
+    int relY = yCoord - this->y;
+    if (relX < 0 || relY < 0 || relX >= this->width || relY >= this->height)
+        throw "Invalid coordinates outside of the frame's bounding box";
+    uint64_t mask = uint64_t(1) << (relX % 64);
+    if (val)
+        this->row(relY)[relX / 64] |= mask;
+    else
+        this->row(relY)[relX / 64] &= ~mask;
+}
+
+long long int GenerationFrame::aliveCount() const {
+    long long int count = 0;
+    for (auto word : this->bits) {
+        count += __builtin_popcountll(word);
+    }
+    return count;
+}
+
+bool GenerationFrame::sameShape(const GenerationFrame& other) const {
+    // padding bits are always 0 so comparing the words is enough
+    return this->width == other.width && this->height == other.height
+            && this->bits == other.bits;
+}
+
+uint64_t GenerationFrame::shapeHash() const {
+    // mix every word into the hash with a multiply and a rotate, which is
+    // cheap but still spreads single bit differences over the whole hash
+    auto mix = [](uint64_t hash, const uint64_t word) {
+        hash ^= word + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        hash *= 0xff51afd7ed558ccdULL;
+        return (hash << 31) | (hash >> 33);
+    };
+    uint64_t hash = mix(0, (static_cast<uint64_t> (this->width) << 32)
+            | static_cast<uint32_t> (this->height));
+    for (auto word : this->bits) {
+        hash = mix(hash, word);
+    }
+    return hash;
+}
+
+bool ShapeHistory::addUnlessSeen(const GenerationFrame& frame,
+        const int parity) {
+    std::vector<int>& sameHash = this->byHash[frame.shapeHash()];
+    for (int i : sameHash) {
+        if (this->parities[i] == parity && this->frames[i].sameShape(frame))
+            return true;
+    }
+    sameHash.push_back(this->frames.size());
+    this->frames.push_back(frame);
+    this->parities.push_back(parity);
+    return false;
+}
+
+void ShapeHistory::clear() {
+    this->byHash.clear();
+    this->frames.clear();
+    this->parities.clear();
+}
+
+std::string GenerationFrame::toRle(const std::string& rule,
+        const int gen) const {
+    std::string rle = "#CXRLE Pos=" + std::to_string(this->x) + ","
+            + std::to_string(this->y);
+    if (gen != 0)
+        rle += " Gen=" + std::to_string(gen);
+    rle += "\nx = " + std::to_string(this->width) + ", y = "
+            + std::to_string(this->height) + ", rule = " + rule + "\n";
+    // golly keeps body lines at most 70 chars long, never splitting a run
+    std::string line;
+    auto addRun = [&](const int count, const char c) {
+        std::string run = (count > 1 ? std::to_string(count) : "") + c;
+        if (line.length() + run.length() > 70) {
+            rle += line + "\n";
+            line = "";
+        }
+        line += run;
+    };
+    int pendingRows = 0; // row ends that have not been written yet
+    for (int relY = 0; relY < this->height; relY++) {
+        int relX = 0;
+        while (relX < this->width) {
+            bool alive = this->getCellVal(this->x + relX, this->y + relY);
+            int runEnd = relX;
+            while (runEnd < this->width && this->getCellVal(this->x + runEnd,
+                    this->y + relY) == alive) {
+                runEnd++;
+            }
+            // trailing dead cells of a row are left out
+            if (alive || runEnd < this->width) {
+                if (pendingRows > 0) {
+                    addRun(pendingRows, '$');
+                    pendingRows = 0;
+                }
+                addRun(runEnd - relX, alive ? 'o' : 'b');
+            }
+            relX = runEnd;
+        }
+        pendingRows++;
+    }
+    line += "!";
+    rle += line + "\n";
+    return rle;
+}
+
+#endif /* GENERATION_FRAME_CPP */
@@ -0,0 +1,87 @@
+/*
+ * File:   GenerationFrame.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef GENERATION_FRAME_H
+#define GENERATION_FRAME_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// one generation of a Life-like pattern cropped to the bounding box of its
+// live cells, which is the same box golly writes into the header of a .rle
+// file. Rows are bit-packed 64 cells to a word: bit b of word w in a row
+// describes the cell at x-coord (x + 64 * w + b). Bits past the width of
+// the frame are always 0.
+struct GenerationFrame {
+    int x = 0; // x-coordinate of top left corner
+    int y = 0; // y-coordinate of top left corner
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0; // number of 64 bit words used for every row
+    std::vector<uint64_t> bits; // height * wordsPerRow words
+
+    // sets the bounding box of the frame and sets every cell dead
+    void resize(const int xCoord, const int yCoord, const int frameWidth,
+            const int frameHeight);
+
+    // true if there are no live cells (width or height is 0)
+    bool empty() const;
+
+    // returns pointer to the first word of the given row (0 is the top row)
+    const uint64_t* row(const int rowNum) const;
+    uint64_t* row(const int rowNum);
+
+    // returns value of the cell at the given coordinates, cells outside of
+    // the bounding box are dead
+    bool getCellVal(const int xCoord, const int yCoord) const;
+
+    // sets the cell at the given coordinates which must be inside the box
+    void setCellVal(const int xCoord, const int yCoord, const bool val);
+
+    // returns number of live cells in the frame
+    long long int aliveCount() const;
+
+    // true if both frames hold the same pattern, ignoring where it is.
+    // This matches the check golly-script.py and the classifier perform on
+    // the encoded body of two .rle files
+    bool sameShape(const GenerationFrame& other) const;
+
+    // returns a 64 bit hash of the pattern that does not depend on where it
+    // is, so frames with the same shape always have the same hash
+    uint64_t shapeHash() const;
+
+    // encodes the frame the same way golly's g.save does: a "#CXRLE" line
+    // with the position, the "x = , y = , rule = " line and the run length
+    // encoded body wrapped at 70 characters
+    std::string toRle(const std::string& rule, const int gen) const;
+};
+
+// the generations of a run looked up by their shapeHash, to find the first
+// one with a shape seen before. Only generations with the same hash are
+// compared with sameShape, so a hash collision is never taken for a repeat.
+// Every generation added is kept until clear, which is what the full compare
+// costs
+class ShapeHistory {
+public:
+    // true if a generation of the same shape was added before with the same
+    // parity, otherwise adds frame with that parity and returns false.
+    // Engines alternating between two rules pass the generation's parity,
+    // since a shape only comes back for good under the same rule
+    bool addUnlessSeen(const GenerationFrame& frame, const int parity = 0);
+
+    // forgets every generation added
+    void clear();
+
+private:
+    // positions in frames of the generations with each hash
+    std::unordered_map<uint64_t, std::vector<int>> byHash;
+    std::vector<GenerationFrame> frames;
+    std::vector<int> parities;
+};
+
+#endif /* GENERATION_FRAME_H */
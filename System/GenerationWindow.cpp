@@ -0,0 +1,136 @@
+#ifndef GENERATION_WINDOW_CPP
+#define GENERATION_WINDOW_CPP
+
+/*
+ * File:   GenerationWindow.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+#include "GenerationWindow.h"
+#include "BitKernels.h"
+
+GenerationWindow::GenerationWindow(const int capacity,
+        const int statePlaneCount) {
+    this->capacity = capacity;
+    this->firstGen = 0;
+    this->lastGen = -1;
+    this->canvasX = 0;
+    this->canvasY = 0;
+    this->canvasWidth = 0;
+    this->canvasHeight = 0;
+    this->wordsPerRow = 0;
+    this->slots.resize(capacity);
+    this->statePlanes.resize(statePlaneCount);
+}
+
+void GenerationWindow::push(const int gen, const GenerationFrame& frame) {
+    if (this->lastGen < this->firstGen) // first generation pushed
+        this->firstGen = gen;
+    else if (gen != this->lastGen + 1)
+        throw "Generations must be pushed to the window in order";
+    this->lastGen = gen;
+    if (this->lastGen - this->firstGen + 1 > this->capacity)
+        this->firstGen++; // oldest generation gets overwritten below
+    if (frame.x < this->canvasX || frame.y < this->canvasY
+            || frame.x + frame.width > this->canvasX + this->canvasWidth
+            || frame.y + frame.height > this->canvasY + this->canvasHeight)
+        this->growCanvas(frame);
+    std::vector<uint64_t>& slot = this->slots[gen % this->capacity];
+    slot.assign(this->getWordsPerGen(), 0);
+    this->placeFrame(slot, frame);
+}
+
+void GenerationWindow::growCanvas(const GenerationFrame& frame) {
+    int minX = frame.x;
+    int minY = frame.y;
+    int maxX = frame.x + frame.width;
+    int maxY = frame.y + frame.height;
+    if (this->canvasWidth > 0) {
+        minX = std::min(minX, this->canvasX);
+        minY = std::min(minY, this->canvasY);
+        maxX = std::max(maxX, this->canvasX + this->canvasWidth);
+        maxY = std::max(maxY, this->canvasY + this->canvasHeight);
+    }
+    // add a quarter of the size (at least 16 cells) of slack on every side
+    const int slackX = std::max(16, (maxX - minX) / 4);
+    const int slackY = std::max(16, (maxY - minY) / 4);
+    const int newX = minX - slackX;
+    const int newY = minY - slackY;
+    const int newWidth = maxX - minX + 2 * slackX;
+    const int newHeight = maxY - minY + 2 * slackY;
+    const int newWordsPerRow = (newWidth + 63) / 64;
+    // move the generations already kept and the state over to the new canvas
+    for (int gen = this->firstGen; gen < this->lastGen; gen++) {
+        this->moveToCanvas(this->slots[gen % this->capacity], newX, newY,
+                newHeight, newWordsPerRow);
+    }
+    for (auto& plane : this->statePlanes) {
+        this->moveToCanvas(plane, newX, newY, newHeight, newWordsPerRow);
+    }
+    this->canvasX = newX;
+    this->canvasY = newY;
+    this->canvasWidth = newWidth;
+    this->canvasHeight = newHeight;
+    this->wordsPerRow = newWordsPerRow;
+}
+
+void GenerationWindow::moveToCanvas(std::vector<uint64_t>& words,
+        const int newX, const int newY, const int newHeight,
+        const int newWordsPerRow) const {
+    std::vector<uint64_t> moved(static_cast<size_t> (newWordsPerRow)
+            * newHeight, 0);
+    if (!words.empty()) {
+        for (int row = 0; row < this->canvasHeight; row++) {
+            bitkernels::orBitsAt(moved.data() + static_cast<size_t> (row
+                    + this->canvasY - newY) * newWordsPerRow,
+                    this->canvasX - newX, words.data()
+                    + static_cast<size_t> (row) * this->wordsPerRow,
+                    this->canvasWidth);
+        }
+    }
+    words.swap(moved);
+}
+
+void GenerationWindow::placeFrame(std::vector<uint64_t>& slot,
+        const GenerationFrame& frame) const {
+    for (int row = 0; row < frame.height; row++) {
+        bitkernels::orBitsAt(slot.data() + static_cast<size_t> (frame.y + row
+                - this->canvasY) * this->wordsPerRow, frame.x - this->canvasX,
+                frame.row(row), frame.width);
+    }
+}
+
+bool GenerationWindow::holds(const int gen) const {
+    return gen >= this->firstGen && gen <= this->lastGen;
+}
+
+const uint64_t* GenerationWindow::getGenWords(const int gen) const {
+    if (!this->holds(gen))
+        throw "Generation is no longer held by the window";
+    return this->slots[gen % this->capacity].data();
+}
+
+uint64_t* GenerationWindow::getStatePlane(const int plane) {
+    return this->statePlanes[plane].data();
+}
+
+long long int GenerationWindow::getWordsPerGen() const {
+    return static_cast<long long> (this->wordsPerRow) * this->canvasHeight;
+}
+
+bool GenerationWindow::getCellVal(const int gen, const int xCoord,
+        const int yCoord) const {
+    const uint64_t* words = this->getGenWords(gen);
+    int relX = xCoord - this->canvasX;
+    int relY = yCoord - this->canvasY;
+    if (relX < 0 || relY < 0 || relX >= this->canvasWidth
+            || relY >= this->canvasHeight)
+        return false;
+    return (words[static_cast<size_t> (relY) * this->wordsPerRow + relX / 64]
+            >> (relX % 64)) & 1;
+}
+
+#endif /* GENERATION_WINDOW_CPP */
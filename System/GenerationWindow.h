@@ -0,0 +1,82 @@
+/*
+ * File:   GenerationWindow.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef GENERATION_WINDOW_H
+#define GENERATION_WINDOW_H
+
+#include <cstdint>
+#include <vector>
+#include "GenerationFrame.h"
+
+// Circular buffer holding only the most recent generations of a run, used
+// by the streaming mode of ConwayClassifier. Every generation kept is laid
+// out on a shared canvas the same way the gameBoard lays out a generation
+// (bit-packed rows starting on a new word), so generations kept can be
+// compared word by word. The window can also hold some per-cell state laid
+// out the same way (state planes), for example counters that are updated
+// every generation. The canvas grows whenever a generation does not fit on
+// it, moving the generations and state planes along with it, and grows by
+// some slack so a slowly expanding pattern doesn't cause a regrow every
+// generation. Cells that weren't on the canvas before start out as 0 in
+// every state plane.
+class GenerationWindow {
+public:
+    // constructor
+    // capacity is the number of most recent generations that are kept and
+    // statePlaneCount the number of state planes
+    GenerationWindow(const int capacity, const int statePlaneCount = 0);
+
+    // adds the next generation, gen has to be one more than the generation
+    // pushed before it (any number to start with). Once the window is full
+    // the oldest generation is dropped
+    void push(const int gen, const GenerationFrame& frame);
+
+    // true if the given generation is still kept
+    bool holds(const int gen) const;
+
+    // returns pointer to the first word of the given generation which must
+    // still be kept
+    const uint64_t* getGenWords(const int gen) const;
+
+    // returns pointer to the first word of the given state plane, only valid
+    // until the next push
+    uint64_t* getStatePlane(const int plane);
+
+    // returns number of words used for every generation on the canvas
+    long long int getWordsPerGen() const;
+
+    // returns value of given cell of a generation that is still kept
+    bool getCellVal(const int gen, const int xCoord, const int yCoord) const;
+
+private:
+    int capacity; // max number of generations kept
+    int firstGen; // oldest generation kept
+    int lastGen; // newest generation kept, firstGen - 1 while empty
+    int canvasX; // x-coordinate of top left corner of the canvas
+    int canvasY; // y-coordinate of top left corner of the canvas
+    int canvasWidth;
+    int canvasHeight;
+    int wordsPerRow;
+    // generation gen is kept in slots[gen % capacity]
+    std::vector<std::vector<uint64_t>> slots;
+    std::vector<std::vector<uint64_t>> statePlanes;
+
+    // moves a generation or state plane laid out on the current canvas over
+    // to a canvas of the given size
+    void moveToCanvas(std::vector<uint64_t>& words, const int newX,
+            const int newY, const int newHeight,
+            const int newWordsPerRow) const;
+
+    // makes the canvas big enough to hold the given frame as well as every
+    // generation already kept, moving the kept generations over to it
+    void growCanvas(const GenerationFrame& frame);
+
+    // ORs the rows of a frame into a slot at its place on the canvas
+    void placeFrame(std::vector<uint64_t>& slot,
+            const GenerationFrame& frame) const;
+};
+
+#endif /* GENERATION_WINDOW_H */
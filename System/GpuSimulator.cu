@@ -0,0 +1,720 @@
+#ifndef GPU_SIMULATOR_CU
+#define GPU_SIMULATOR_CU
+
+/*
+ * File:   GpuSimulator.cu
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <cstdio>
+#include <climits>
+#include <limits>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cuda_runtime.h>
+#include "GpuSimulator.h"
+#include "SimulationEngine.h"
+#include "LifeSimulator.h"
+#include "ConwayClassifier.h"
+
+namespace {
+
+const int blockThreads = 256;
+const int settleThreads = 64;
+// same as the ConwayClassifier constants of the same names
+const int consecutiveAliveLen = 5;
+const int deadWithinLen = 25;
+const int runCounterBits = 5;
+
+// everything the loop of SimulationEngine::run and the streaming
+// ConwayClassifier keep for a rule, plus what the kernels of the current
+// generation found out about it
+struct RuleState {
+    int running; // 0 once the simulation loop has stopped
+    int settledClass; // see SimulationEngine::getSettledClass
+    int pushedGenCount;
+    int patternRepeated;
+    // 1 if a shape had the hash of a generation that didn't fit in the
+    // history, so the rule is run again on the host instead
+    int unverified;
+    // bounding box of the live cells of the current generation in board
+    // coordinates, minX > maxX if there are none
+    int minX;
+    int maxX;
+    int minY;
+    int maxY;
+    unsigned long long int population;
+    unsigned long long int changedCount; // cells that differ from gen - 1
+    unsigned long long int activeCount;
+    // size of the frame kept in each of the two frame slots
+    int frameWidth[2];
+    int frameHeight[2];
+    // words of the frame that differ from the frame before it, only counted
+    // if the two are the same size
+    unsigned long long int frameDiff;
+    double aliveSum;
+    double percentSum;
+    double activeSum;
+};
+
+// shape of the buffers, the same for every rule
+struct Layout {
+    int ruleCount;
+    int rows;
+    int wordsPerRow;
+    long long int gridWords;
+    int genNum;
+    int statStartGen;
+    int runStartGen;
+    unsigned long long int historyWords; // size of the history pool
+};
+
+// where the words of a generation's frame were kept in the history pool,
+// offset is -1 if the pool was full
+struct FrameRecord {
+    long long int offset;
+    int width;
+    int height;
+};
+
+// birth and survival masks of a rule for even and odd generations
+struct DeviceRule {
+    uint16_t birth[2];
+    uint16_t survive[2];
+    int alternating;
+};
+
+void checkCuda(const cudaError_t result) {
+    if (result != cudaSuccess) {
+        std::fprintf(stderr, "CUDA error: %s\n", cudaGetErrorString(result));
+        throw "CUDA call failed";
+    }
+}
+
+// owns the device memory of a run
+struct DeviceBuffers {
+    uint64_t* grids[2] = {nullptr, nullptr}; // generation gen is in gen % 2
+    uint64_t* frames = nullptr; // two frame slots of gridWords per rule
+    uint64_t* counters = nullptr; // runCounterBits + 1 planes per rule
+    uint64_t* hashes = nullptr; // shape hash of every generation per rule
+    // frame of every generation per rule, to compare shapes whose hashes
+    // match. The frames are packed one after another in the pool as they
+    // come, since their sizes aren't known up front
+    FrameRecord* records = nullptr;
+    uint64_t* history = nullptr;
+    unsigned long long int* historyTop = nullptr;
+    RuleState* states = nullptr;
+    DeviceRule* rules = nullptr;
+    int* runningCount = nullptr;
+
+    ~DeviceBuffers() {
+        cudaFree(this->grids[0]);
+        cudaFree(this->grids[1]);
+        cudaFree(this->frames);
+        cudaFree(this->counters);
+        cudaFree(this->hashes);
+        cudaFree(this->records);
+        cudaFree(this->history);
+        cudaFree(this->historyTop);
+        cudaFree(this->states);
+        cudaFree(this->rules);
+        cudaFree(this->runningCount);
+    }
+};
+
+template <typename T>
+void allocZeroed(T** ptr, const size_t count) {
+    checkCuda(cudaMalloc(reinterpret_cast<void**> (ptr), count * sizeof (T)));
+    checkCuda(cudaMemset(*ptr, 0, count * sizeof (T)));
+}
+
+// advances word w of a board row by one generation with the full adders
+// LifeSimulator uses
+__device__ uint64_t stepWord(const uint64_t* grid, const Layout& layout,
+        const int row, const int w, const uint16_t birth,
+        const uint16_t survive) {
+    uint64_t n[8];
+    int count = 0;
+    uint64_t self = 0;
+    for (int r = -1; r <= 1; r++) {
+        uint64_t center = 0;
+        uint64_t left = 0;
+        uint64_t right = 0;
+        if (row + r >= 0 && row + r < layout.rows) {
+            const uint64_t* gridRow = grid
+                    + static_cast<long long int> (row + r) * layout.wordsPerRow;
+            center = gridRow[w];
+            left = w > 0 ? gridRow[w - 1] : 0;
+            right = w + 1 < layout.wordsPerRow ? gridRow[w + 1] : 0;
+        }
+        n[count++] = (center << 1) | (left >> 63);
+        n[count++] = (center >> 1) | (right << 63);
+        if (r != 0)
+            n[count++] = center;
+        else
+            self = center;
+    }
+    const uint64_t t0 = n[0] ^ n[1];
+    const uint64_t s0 = t0 ^ n[2];
+    const uint64_t c0 = (n[0] & n[1]) | (t0 & n[2]);
+    const uint64_t t1 = n[3] ^ n[4];
+    const uint64_t s1 = t1 ^ n[5];
+    const uint64_t c1 = (n[3] & n[4]) | (t1 & n[5]);
+    const uint64_t s2 = n[6] ^ n[7];
+    const uint64_t c2 = n[6] & n[7];
+    const uint64_t t3 = s0 ^ s1;
+    const uint64_t bit0 = t3 ^ s2;
+    const uint64_t c3 = (s0 & s1) | (t3 & s2);
+    const uint64_t t4 = c0 ^ c1;
+    const uint64_t s4 = t4 ^ c2;
+    const uint64_t c4 = (c0 & c1) | (t4 & c2);
+    const uint64_t bit1 = s4 ^ c3;
+    const uint64_t c5 = s4 & c3;
+    const uint64_t bit2 = c4 ^ c5;
+    const uint64_t bit3 = c4 & c5;
+    const uint64_t planes[4] = {bit0, bit1, bit2, bit3};
+    uint64_t next = 0;
+    for (int c = 0; c <= 8; c++) {
+        if (!((birth | survive) & (1 << c)))
+            continue;
+        uint64_t match = ~uint64_t(0);
+        for (int b = 0; b < 4; b++) {
+            match &= (c >> b) & 1 ? planes[b] : ~planes[b];
+        }
+        if (birth & (1 << c))
+            next |= match & ~self;
+        if (survive & (1 << c))
+            next |= match & self;
+    }
+    return next;
+}
+
+// steps every running rule from cur to next, one thread per word. Words
+// more than a cell away from the live cells can only be dead
+__global__ void stepKernel(const uint64_t* cur, uint64_t* next,
+        const RuleState* states, const DeviceRule* rules, const Layout layout,
+        const int parity) {
+    const int rule = blockIdx.y;
+    const long long int i = static_cast<long long int> (blockIdx.x)
+            * blockDim.x + threadIdx.x;
+    const RuleState& state = states[rule];
+    if (i >= layout.gridWords || !state.running)
+        return;
+    const int row = i / layout.wordsPerRow;
+    const int w = i % layout.wordsPerRow;
+    uint64_t* out = next + rule * layout.gridWords;
+    if (row < state.minY - 1 || row > state.maxY + 1
+            || w < (state.minX - 1) / 64 || w > (state.maxX + 1) / 64) {
+        out[i] = 0;
+        return;
+    }
+    out[i] = stepWord(cur + rule * layout.gridWords, layout, row, w,
+            rules[rule].birth[parity], rules[rule].survive[parity]);
+}
+
+// clears what the kernels of the last generation found out
+__global__ void resetKernel(RuleState* states, const int ruleCount) {
+    const int rule = blockIdx.x * blockDim.x + threadIdx.x;
+    if (rule >= ruleCount)
+        return;
+    RuleState& state = states[rule];
+    state.minX = INT_MAX;
+    state.maxX = -1;
+    state.minY = INT_MAX;
+    state.maxY = -1;
+    state.population = 0;
+    state.changedCount = 0;
+    state.activeCount = 0;
+    state.frameDiff = 0;
+}
+
+// same as ConwayClassifier::advanceRunCounters for a single word
+__device__ uint64_t advanceRunCounters(const uint64_t alive,
+        uint64_t* counters, const long long int i, const Layout& layout,
+        const int gen) {
+    const int minRun = consecutiveAliveLen + 1;
+    const int maxRun = deadWithinLen;
+    uint64_t carry = ~uint64_t(0);
+    for (int p = 0; p < runCounterBits; p++) {
+        carry &= counters[p * layout.gridWords + i];
+    }
+    carry = alive & ~carry;
+    for (int p = 0; p < runCounterBits; p++) {
+        uint64_t& plane = counters[p * layout.gridWords + i];
+        const uint64_t next = plane & carry;
+        plane = (plane ^ carry) & alive;
+        carry = next;
+    }
+    uint64_t atLeastMin = 0;
+    uint64_t atLeastMax = 0;
+    uint64_t equalMin = ~uint64_t(0);
+    uint64_t equalMax = ~uint64_t(0);
+    for (int p = runCounterBits - 1; p >= 0; p--) {
+        const uint64_t plane = counters[p * layout.gridWords + i];
+        const uint64_t minBit = ((minRun >> p) & 1) ? ~uint64_t(0) : 0;
+        const uint64_t maxBit = (((maxRun + 1) >> p) & 1) ? ~uint64_t(0) : 0;
+        atLeastMin |= equalMin & plane & ~minBit;
+        equalMin &= ~(plane ^ minBit);
+        atLeastMax |= equalMax & plane & ~maxBit;
+        equalMax &= ~(plane ^ maxBit);
+    }
+    uint64_t active = (atLeastMin | equalMin) & ~(atLeastMax | equalMax);
+    if (layout.runStartGen == 0) {
+        uint64_t& sinceStart = counters[runCounterBits * layout.gridWords + i];
+        sinceStart = gen == 0 ? alive : sinceStart & alive;
+        active &= ~sinceStart;
+    }
+    return active;
+}
+
+// counts the live, changed and active cells of every running rule and finds
+// their bounding boxes, one thread per word. Every block adds up the words
+// of its threads before touching the rule's state
+__global__ void scanKernel(const uint64_t* cur, const uint64_t* prev,
+        uint64_t* counters, RuleState* states, const Layout layout,
+        const int gen) {
+    __shared__ unsigned long long int sums[3][blockThreads];
+    __shared__ int edges[4][blockThreads];
+    const int rule = blockIdx.y;
+    const long long int i = static_cast<long long int> (blockIdx.x)
+            * blockDim.x + threadIdx.x;
+    // the same for the whole block
+    if (!states[rule].running)
+        return;
+    unsigned long long int population = 0;
+    unsigned long long int changed = 0;
+    unsigned long long int active = 0;
+    int minX = INT_MAX;
+    int maxX = -1;
+    int minY = INT_MAX;
+    int maxY = -1;
+    if (i < layout.gridWords) {
+        const long long int offset = rule * layout.gridWords;
+        const uint64_t word = cur[offset + i];
+        population = __popcll(word);
+        changed = __popcll(word ^ prev[offset + i]);
+        if (word != 0) {
+            const int row = i / layout.wordsPerRow;
+            const int w = i % layout.wordsPerRow;
+            minY = maxY = row;
+            minX = w * 64 + __ffsll(word) - 1;
+            maxX = w * 64 + 63 - __clzll(word);
+        }
+        if (gen >= layout.runStartGen) {
+            active = __popcll(advanceRunCounters(word, counters
+                    + rule * (runCounterBits + 1) * layout.gridWords, i,
+                    layout, gen));
+        }
+    }
+    const int t = threadIdx.x;
+    sums[0][t] = population;
+    sums[1][t] = changed;
+    sums[2][t] = active;
+    edges[0][t] = minX;
+    edges[1][t] = maxX;
+    edges[2][t] = minY;
+    edges[3][t] = maxY;
+    __syncthreads();
+    for (int half = blockDim.x / 2; half > 0; half /= 2) {
+        if (t < half) {
+            for (int s = 0; s < 3; s++) {
+                sums[s][t] += sums[s][t + half];
+            }
+            edges[0][t] = min(edges[0][t], edges[0][t + half]);
+            edges[1][t] = max(edges[1][t], edges[1][t + half]);
+            edges[2][t] = min(edges[2][t], edges[2][t + half]);
+            edges[3][t] = max(edges[3][t], edges[3][t + half]);
+        }
+        __syncthreads();
+    }
+    if (t == 0 && sums[0][0] != 0) {
+        RuleState& state = states[rule];
+        atomicAdd(&state.population, sums[0][0]);
+        atomicAdd(&state.activeCount, sums[2][0]);
+        atomicMin(&state.minX, edges[0][0]);
+        atomicMax(&state.maxX, edges[1][0]);
+        atomicMin(&state.minY, edges[2][0]);
+        atomicMax(&state.maxY, edges[3][0]);
+    }
+    if (t == 0 && sums[1][0] != 0)
+        atomicAdd(&states[rule].changedCount, sums[1][0]);
+}
+
+// crops the current generation of every running rule to its live cells,
+// the same rows GenerationFrame holds, into the frame slot of the
+// generation and compares it with the frame of the generation before. One
+// block per rule
+__global__ void frameKernel(const uint64_t* cur, uint64_t* frames,
+        RuleState* states, const Layout layout, const int gen) {
+    const int rule = blockIdx.x;
+    RuleState& state = states[rule];
+    if (!state.running || state.population == 0)
+        return;
+    const int slot = gen % 2;
+    const int width = state.maxX - state.minX + 1;
+    const int height = state.maxY - state.minY + 1;
+    const int frameWordsPerRow = (width + 63) / 64;
+    const int tailBits = width % 64;
+    const uint64_t tailMask = tailBits == 0 ? ~uint64_t(0)
+            : (uint64_t(1) << tailBits) - 1;
+    uint64_t* frame = frames + (static_cast<long long int> (slot)
+            * layout.ruleCount + rule) * layout.gridWords;
+    const uint64_t* prevFrame = frames + (static_cast<long long int> (1 - slot)
+            * layout.ruleCount + rule) * layout.gridWords;
+    const bool compare = gen > 0 && state.frameWidth[1 - slot] == width
+            && state.frameHeight[1 - slot] == height;
+    const uint64_t* grid = cur + rule * layout.gridWords;
+    const long long int frameWords = static_cast<long long int> (height)
+            * frameWordsPerRow;
+    for (long long int k = threadIdx.x; k < frameWords; k += blockDim.x) {
+        const int r = k / frameWordsPerRow;
+        const int c = k % frameWordsPerRow;
+        const uint64_t* gridRow = grid + static_cast<long long int> (
+                state.minY + r) * layout.wordsPerRow;
+        const int bitPos = state.minX + 64 * c;
+        const int word = bitPos / 64;
+        const int shift = bitPos % 64;
+        uint64_t bits = gridRow[word] >> shift;
+        if (shift != 0 && word + 1 < layout.wordsPerRow)
+            bits |= gridRow[word + 1] << (64 - shift);
+        if (c == frameWordsPerRow - 1)
+            bits &= tailMask;
+        frame[k] = bits;
+        if (compare && bits != prevFrame[k])
+            atomicAdd(&state.frameDiff, 1ULL);
+    }
+    if (threadIdx.x == 0) {
+        state.frameWidth[slot] = width;
+        state.frameHeight[slot] = height;
+    }
+}
+
+// same as GenerationFrame::shapeHash
+__device__ uint64_t mixHash(uint64_t hash, const uint64_t word) {
+    hash ^= word + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash *= 0xff51afd7ed558ccdULL;
+    return (hash << 31) | (hash >> 33);
+}
+
+// hands the current generation of every running rule to its classifier and
+// runs the stop checks, one thread per rule. This is the per generation
+// part of SimulationEngine::run and ConwayClassifier::pushGeneration
+__global__ void settleKernel(const uint64_t* frames, RuleState* states,
+        uint64_t* hashes, FrameRecord* records, uint64_t* history,
+        unsigned long long int* historyTop, const DeviceRule* rules,
+        const Layout layout, const int gen, int* runningCount) {
+    const int rule = blockIdx.x * blockDim.x + threadIdx.x;
+    if (rule >= layout.ruleCount)
+        return;
+    RuleState& state = states[rule];
+    if (!state.running)
+        return;
+    // stop if universe is empty
+    if (state.population == 0) {
+        state.settledClass = 1;
+        state.running = 0;
+        return;
+    }
+    const int slot = gen % 2;
+    const int width = state.frameWidth[slot];
+    const int height = state.frameHeight[slot];
+    const uint64_t* frame = frames + (static_cast<long long int> (slot)
+            * layout.ruleCount + rule) * layout.gridWords;
+    const long long int frameWords = static_cast<long long int> (height)
+            * ((width + 63) / 64);
+    uint64_t hash = mixHash(0, (static_cast<uint64_t> (width) << 32)
+            | static_cast<uint32_t> (height));
+    for (long long int k = 0; k < frameWords; k++) {
+        hash = mixHash(hash, frame[k]);
+    }
+    // the classifier looks for any shape seen before, the simulation loop
+    // only for one that makes every later generation a repeat too. Same
+    // hashes only count once the frames compare equal, like ShapeHistory
+    uint64_t* seen = hashes + static_cast<long long int> (rule)
+            * (layout.genNum + 1);
+    FrameRecord* record = records + static_cast<long long int> (rule)
+            * (layout.genNum + 1);
+    bool cycled = false;
+    for (int j = 0; j < gen; j++) {
+        if (seen[j] != hash)
+            continue;
+        if (record[j].offset < 0) {
+            state.unverified = 1;
+            continue;
+        }
+        if (record[j].width != width || record[j].height != height)
+            continue;
+        const uint64_t* kept = history + record[j].offset;
+        bool same = true;
+        for (long long int k = 0; k < frameWords && same; k++) {
+            same = kept[k] == frame[k];
+        }
+        if (!same)
+            continue;
+        state.patternRepeated = 1;
+        if (!rules[rule].alternating || j % 2 == gen % 2)
+            cycled = true;
+    }
+    if (state.unverified) {
+        state.running = 0;
+        return;
+    }
+    seen[gen] = hash;
+    const unsigned long long int offset = atomicAdd(historyTop,
+            static_cast<unsigned long long int> (frameWords));
+    record[gen].width = width;
+    record[gen].height = height;
+    if (offset + frameWords <= layout.historyWords) {
+        record[gen].offset = offset;
+        for (long long int k = 0; k < frameWords; k++) {
+            history[offset + k] = frame[k];
+        }
+    } else
+        record[gen].offset = -1;
+    state.pushedGenCount++;
+    if (!state.patternRepeated && gen >= layout.statStartGen) {
+        const double area = static_cast<double> (width) * height;
+        state.aliveSum += state.population / area;
+        // the classifier only has gen - 1 if it has seen it
+        if (gen - 1 >= layout.runStartGen)
+            state.percentSum += state.changedCount / area;
+        state.activeSum += state.activeCount / area;
+    }
+    // same check as compare_rle in golly-script.py
+    if (gen > 0 && state.frameWidth[1 - slot] == width
+            && state.frameHeight[1 - slot] == height && state.frameDiff == 0) {
+        if (gen < layout.genNum)
+            state.settledClass = 1;
+        state.running = 0;
+        return;
+    }
+    if (gen < layout.genNum && cycled) {
+        state.settledClass = 2;
+        state.running = 0;
+        return;
+    }
+    atomicAdd(runningCount, 1);
+}
+
+// device memory a rule of the batch takes, the history pool aside
+size_t bytesPerRule(const Layout& layout) {
+    // two grids, two frame slots and the counter planes
+    return (4 + runCounterBits + 1) * layout.gridWords * sizeof (uint64_t)
+            + (layout.genNum + 1) * (sizeof (uint64_t) + sizeof (FrameRecord))
+            + sizeof (RuleState) + sizeof (DeviceRule);
+}
+
+// simulates rules[first] to rules[first + layout.ruleCount - 1] on the
+// device and returns their states once every one of them has stopped.
+// Throws if the device memory can't be had
+std::vector<RuleState> simulateBatch(const std::vector<DeviceRule>& rules,
+        const int first, Layout layout, const std::vector<uint64_t>& soup) {
+    const int ruleCount = layout.ruleCount;
+    const int genNum = layout.genNum;
+    const int generationCount = genNum + 1;
+    std::vector<RuleState> states(ruleCount);
+    for (int r = 0; r < ruleCount; r++) {
+        states[r] = RuleState();
+        states[r].running = 1;
+    }
+
+    DeviceBuffers device;
+    const size_t boardWords = static_cast<size_t> (ruleCount)
+            * layout.gridWords;
+    allocZeroed(&device.grids[0], boardWords);
+    allocZeroed(&device.grids[1], boardWords);
+    allocZeroed(&device.frames, 2 * boardWords);
+    allocZeroed(&device.counters, (runCounterBits + 1) * boardWords);
+    allocZeroed(&device.hashes, static_cast<size_t> (ruleCount)
+            * generationCount);
+    allocZeroed(&device.records, static_cast<size_t> (ruleCount)
+            * generationCount);
+    allocZeroed(&device.historyTop, 1);
+    allocZeroed(&device.states, ruleCount);
+    allocZeroed(&device.rules, ruleCount);
+    allocZeroed(&device.runningCount, 1);
+    // the history gets half of what is left, a rule that runs out of it is
+    // only simulated on the host if its hashes match one it couldn't keep
+    size_t freeBytes = 0;
+    size_t totalBytes = 0;
+    checkCuda(cudaMemGetInfo(&freeBytes, &totalBytes));
+    layout.historyWords = std::max<size_t> (freeBytes / 2 / sizeof (uint64_t),
+            1);
+    checkCuda(cudaMalloc(reinterpret_cast<void**> (&device.history),
+            layout.historyWords * sizeof (uint64_t)));
+    for (int r = 0; r < ruleCount; r++) {
+        checkCuda(cudaMemcpy(device.grids[0] + r * layout.gridWords,
+                soup.data(), layout.gridWords * sizeof (uint64_t),
+                cudaMemcpyHostToDevice));
+    }
+    checkCuda(cudaMemcpy(device.states, states.data(),
+            ruleCount * sizeof (RuleState), cudaMemcpyHostToDevice));
+    checkCuda(cudaMemcpy(device.rules, rules.data() + first,
+            ruleCount * sizeof (DeviceRule), cudaMemcpyHostToDevice));
+
+    const dim3 wordGrid((layout.gridWords + blockThreads - 1) / blockThreads,
+            ruleCount);
+    const int ruleBlocks = (ruleCount + settleThreads - 1) / settleThreads;
+    for (int gen = 0; gen <= genNum; gen++) {
+        uint64_t* cur = device.grids[gen % 2];
+        uint64_t* other = device.grids[(gen + 1) % 2];
+        if (gen > 0) {
+            stepKernel<<<wordGrid, blockThreads>>>(other, cur, device.states,
+                    device.rules, layout, (gen - 1) % 2);
+        }
+        resetKernel<<<ruleBlocks, settleThreads>>>(device.states, ruleCount);
+        scanKernel<<<wordGrid, blockThreads>>>(cur, other, device.counters,
+                device.states, layout, gen);
+        frameKernel<<<ruleCount, blockThreads>>>(cur, device.frames,
+                device.states, layout, gen);
+        checkCuda(cudaMemset(device.runningCount, 0, sizeof (int)));
+        settleKernel<<<ruleBlocks, settleThreads>>>(device.frames,
+                device.states, device.hashes, device.records, device.history,
+                device.historyTop, device.rules, layout, gen,
+                device.runningCount);
+        checkCuda(cudaGetLastError());
+        // the one number that has to come back every generation
+        int runningCount = 0;
+        checkCuda(cudaMemcpy(&runningCount, device.runningCount, sizeof (int),
+                cudaMemcpyDeviceToHost));
+        if (runningCount == 0)
+            break;
+    }
+    checkCuda(cudaMemcpy(states.data(), device.states,
+            ruleCount * sizeof (RuleState), cudaMemcpyDeviceToHost));
+    return states;
+}
+
+} // namespace
+
+GpuSimulator::GpuSimulator(const std::vector<std::string>& chromosomes,
+        const int gridSize, const int fillPercent, const unsigned int seed) {
+    int deviceCount = 0;
+    if (cudaGetDeviceCount(&deviceCount) != cudaSuccess || deviceCount == 0)
+        throw "No CUDA device found";
+    this->chromosomes = chromosomes;
+    this->gridSize = gridSize;
+    this->fillPercent = fillPercent;
+    this->seed = seed;
+}
+
+std::vector<RuleMetrics> GpuSimulator::run(const int genNum,
+        const int endCalcPercent) {
+    const int ruleCount = this->chromosomes.size();
+    std::vector<RuleMetrics> metrics(ruleCount);
+    if (ruleCount == 0)
+        return metrics;
+    // patterns grow by at most a cell a generation, so with genNum + 2 dead
+    // cells around the soup nothing ever gets near the edge
+    const int pad = genNum + 2;
+    Layout layout;
+    layout.rows = this->gridSize + 2 * pad;
+    layout.wordsPerRow = (layout.rows + 63) / 64;
+    layout.gridWords = static_cast<long long int> (layout.rows)
+            * layout.wordsPerRow;
+    layout.genNum = genNum;
+    // same as ConwayClassifier::initializeGenCounts and getRunStartGen
+    const int generationCount = genNum + 1;
+    const int statCalcLength = (int) (((double) generationCount / 100)
+            * (double) endCalcPercent);
+    layout.statStartGen = generationCount - statCalcLength;
+    layout.runStartGen = std::max(0, layout.statStartGen - deadWithinLen);
+
+    std::vector<uint64_t> soup(layout.gridWords, 0);
+    SimulationEngine::fillSoup(this->gridSize, this->fillPercent, this->seed,
+            [&](const int x, const int y) {
+        soup[static_cast<long long int> (y + pad) * layout.wordsPerRow
+                + (x + pad) / 64] |= uint64_t(1) << ((x + pad) % 64);
+    });
+    std::vector<DeviceRule> rules(ruleCount);
+    for (int r = 0; r < ruleCount; r++) {
+        const SimulationEngine::RuleMasks masks
+                = SimulationEngine::getRuleMasks(this->chromosomes[r]);
+        rules[r].birth[0] = masks.evenBirth;
+        rules[r].birth[1] = masks.oddBirth;
+        rules[r].survive[0] = masks.evenSurvive;
+        rules[r].survive[1] = masks.oddSurvive;
+        rules[r].alternating = masks.evenBirth != masks.oddBirth
+                || masks.evenSurvive != masks.oddSurvive;
+    }
+
+    // the rules are run in batches that take up to half of the free device
+    // memory, leaving the rest for the history. A batch the device fails on
+    // after all is halved, and a rule that doesn't fit or fails on its own
+    // is simulated on the host
+    const double undefined = std::numeric_limits<double>::quiet_NaN();
+    int maxBatch = ruleCount;
+    for (int first = 0; first < ruleCount;) {
+        size_t freeBytes = 0;
+        size_t totalBytes = 0;
+        size_t fitting = 0;
+        if (cudaMemGetInfo(&freeBytes, &totalBytes) == cudaSuccess)
+            fitting = freeBytes / 2 / bytesPerRule(layout);
+        layout.ruleCount = (int) std::min<size_t> (
+                std::min(maxBatch, ruleCount - first), fitting);
+        std::vector<RuleState> states;
+        bool simulated = false;
+        if (layout.ruleCount > 0) {
+            try {
+                states = simulateBatch(rules, first, layout, soup);
+                simulated = true;
+            } catch (const char*) {
+                if (layout.ruleCount > 1) {
+                    maxBatch = std::max(1, layout.ruleCount / 2);
+                    continue;
+                }
+            }
+        }
+        if (!simulated) {
+            metrics[first] = this->runOnHost(this->chromosomes[first], genNum,
+                    endCalcPercent);
+            first++;
+            continue;
+        }
+        // same as ConwayClassifier::finishGenerations, the stats of anything
+        // but class 3 are thrown away, which leaves their averages undefined
+        for (int b = 0; b < layout.ruleCount; b++) {
+            const RuleState& state = states[b];
+            const int r = first + b;
+            if (state.unverified) {
+                metrics[r] = this->runOnHost(this->chromosomes[r], genNum,
+                        endCalcPercent);
+                continue;
+            }
+            unsigned short int classNum = 3;
+            if (state.settledClass == 2
+                    || (state.pushedGenCount == generationCount
+                    && state.patternRepeated))
+                classNum = 2;
+            else if (state.pushedGenCount != generationCount)
+                classNum = 1;
+            if (classNum != 3) {
+                metrics[r] = {undefined, undefined, undefined, classNum};
+            } else {
+                metrics[r] = {state.aliveSum / statCalcLength,
+                    state.percentSum / statCalcLength,
+                    state.activeSum / statCalcLength, classNum};
+            }
+        }
+        first += layout.ruleCount;
+    }
+    return metrics;
+}
+
+RuleMetrics GpuSimulator::runOnHost(const std::string& chromosome,
+        const int genNum, const int endCalcPercent) const {
+    // the same run main.cpp does for the Native backend
+    LifeSimulator sim(chromosome, this->gridSize, this->fillPercent,
+            this->seed);
+    ConwayClassifier c(chromosome, genNum, endCalcPercent);
+    sim.run(genNum, [&](const GenerationFrame& frame) {
+        c.pushGeneration(frame);
+    }, true);
+    c.finishGenerations(sim.getSettledClass() == 2);
+    return {c.getAliveCellRatio(), c.getPercentChange(),
+        c.getActiveCellRatio(), c.classification()};
+}
+
+#endif /* GPU_SIMULATOR_CU */
@@ -0,0 +1,56 @@
+/*
+ * File:   GpuSimulator.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef GPU_SIMULATOR_H
+#define GPU_SIMULATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FitnessCache.h"
+
+// CUDA simulation engine for a whole population at once, only built with
+// CAGA_WITH_CUDA (see GpuSimulator.cu). Every rule gets its own bit-packed
+// board on the device, big enough that nothing can reach its edge within
+// the generations simulated, so it behaves exactly like the unbounded plane
+// of the other engines. The rules are stepped, checked for stopping and
+// classified the same way a LifeSimulator feeding a streaming
+// ConwayClassifier would do it, and the stats are added up on the device
+// too, so no board or frame ever goes back to the host, only the
+// RuleMetrics of every rule. Frames are kept on the device to compare the
+// shapes whose hashes match, a rule with a match the device had no room to
+// compare is run again with a LifeSimulator on the host.
+class GpuSimulator {
+public:
+    // constructor
+    // takes the 18 char chromosomes of the rules and fills the gridSize x
+    // gridSize square at the origin with the same soup LifeSimulator would
+    // for the seed, for every rule. Throws if there is no CUDA device
+    GpuSimulator(const std::vector<std::string>& chromosomes,
+            const int gridSize, const int fillPercent, const unsigned int seed);
+
+    // runs every rule for up to genNum generations like
+    // SimulationEngine::run does with stopWhenSettled, and returns the
+    // metrics a streaming ConwayClassifier with the same genNum and
+    // endCalcPercent would have found for each one, in order. The device
+    // memory is only held while the run lasts since the boards are sized
+    // for genNum. The rules are run in batches that fit in the free device
+    // memory, a rule the device can't take at all is run on the host
+    std::vector<RuleMetrics> run(const int genNum, const int endCalcPercent);
+
+private:
+    std::vector<std::string> chromosomes;
+    int gridSize;
+    int fillPercent;
+    unsigned int seed;
+
+    // classifies one rule with a LifeSimulator and a streaming
+    // ConwayClassifier instead of on the device
+    RuleMetrics runOnHost(const std::string& chromosome, const int genNum,
+            const int endCalcPercent) const;
+};
+
+#endif /* GPU_SIMULATOR_H */
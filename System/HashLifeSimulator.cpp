@@ -0,0 +1,425 @@
+#ifndef HASH_LIFE_SIMULATOR_CPP
+#define HASH_LIFE_SIMULATOR_CPP
+
+/*
+ * File:   HashLifeSimulator.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "HashLifeSimulator.h"
+
+HashLifeSimulator::HashLifeSimulator(const std::string& chromosome,
+        const int gridSize, const int fillPercent, const unsigned int seed)
+        : SimulationEngine(chromosome) {
+    this->makeLeaves();
+    this->makeLeafSteps();
+    GenerationFrame soup;
+    soup.resize(0, 0, gridSize, gridSize);
+    this->fillSoup(gridSize, fillPercent, seed, [&](const int x, const int y) {
+        soup.setCellVal(x, y, true);
+    });
+    // the universe is centered on the origin so it has to reach gridSize
+    // to the right and down
+    int level = minRootLevel;
+    while ((1LL << (level - 1)) < gridSize) {
+        level++;
+    }
+    const long long int half = 1LL << (level - 1);
+    this->root = this->buildNode(soup, level, -half, -half);
+    this->shrinkRoot();
+}
+
+void HashLifeSimulator::makeLeaves() {
+    this->buckets.assign(1 << 16, nullptr);
+    this->nodes.push_back({nullptr, nullptr, nullptr, nullptr, nullptr, 0, 0,
+        nullptr, -1, 0});
+    this->deadCell = &this->nodes.back();
+    this->nodes.push_back({nullptr, nullptr, nullptr, nullptr, nullptr, 0, 1,
+        nullptr, -1, 1});
+    this->aliveCell = &this->nodes.back();
+    this->emptyNodes.assign(1, this->deadCell);
+}
+
+void HashLifeSimulator::makeLeafSteps() {
+    // the 8 neighbours of each of the 4 center cells
+    uint16_t neighbourMasks[4];
+    for (int c = 0; c < 4; c++) {
+        const int cellX = 1 + c % 2;
+        const int cellY = 1 + c / 2;
+        neighbourMasks[c] = 0;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                if (dx != 0 || dy != 0)
+                    neighbourMasks[c] |= 1 << (4 * (cellY + dy) + cellX + dx);
+            }
+        }
+    }
+    // odd generations only have a rule of their own if the rule alternates
+    const int parityCount = this->alternating() ? 2 : 1;
+    for (int parity = 0; parity < parityCount; parity++) {
+        const uint16_t birth = parity == 1 ? this->oddBirth : this->evenBirth;
+        const uint16_t survive = parity == 1 ? this->oddSurvive
+                : this->evenSurvive;
+        for (int cells = 0; cells < (1 << 16); cells++) {
+            uint8_t center = 0;
+            for (int c = 0; c < 4; c++) {
+                const int neighbours = __builtin_popcount(cells
+                        & neighbourMasks[c]);
+                const bool self = (cells >> (5 + 4 * (c / 2) + c % 2)) & 1;
+                if (((self ? survive : birth) >> neighbours) & 1)
+                    center |= 1 << c;
+            }
+            this->leafSteps[parity][cells] = center;
+        }
+    }
+}
+
+size_t HashLifeSimulator::getBucket(const Node* nw, const Node* ne,
+        const Node* sw, const Node* se) const {
+    size_t hash = reinterpret_cast<size_t> (nw);
+    hash = hash * 0x9e3779b97f4a7c15ULL + reinterpret_cast<size_t> (ne);
+    hash = hash * 0x9e3779b97f4a7c15ULL + reinterpret_cast<size_t> (sw);
+    hash = hash * 0x9e3779b97f4a7c15ULL + reinterpret_cast<size_t> (se);
+    hash ^= hash >> 32;
+    return hash & (this->buckets.size() - 1);
+}
+
+HashLifeSimulator::Node* HashLifeSimulator::getNode(Node* nw, Node* ne,
+        Node* sw, Node* se) {
+    size_t bucket = this->getBucket(nw, ne, sw, se);
+    for (Node* node = this->buckets[bucket]; node != nullptr;
+            node = node->next) {
+        if (node->nw == nw && node->ne == ne && node->sw == sw
+                && node->se == se)
+            return node;
+    }
+    if (this->nodes.size() > this->buckets.size()) {
+        // keep about one node per bucket
+        std::vector<Node*> grown(this->buckets.size() * 2, nullptr);
+        this->buckets.swap(grown);
+        for (Node* head : grown) {
+            while (head != nullptr) {
+                Node* next = head->next;
+                size_t moved = this->getBucket(head->nw, head->ne, head->sw,
+                        head->se);
+                head->next = this->buckets[moved];
+                this->buckets[moved] = head;
+                head = next;
+            }
+        }
+        bucket = this->getBucket(nw, ne, sw, se);
+    }
+    uint16_t cells = 0;
+    if (nw->level == 0) {
+        cells = nw->cells | ne->cells << 1 | sw->cells << 2 | se->cells << 3;
+    } else if (nw->level == 1) {
+        // every 2x2 quadrant goes into two rows of the 4x4 block
+        auto spread = [](const uint16_t quadrant) {
+            return (quadrant & 3) | (quadrant & 12) << 2;
+        };
+        cells = spread(nw->cells) | spread(ne->cells) << 2
+                | spread(sw->cells) << 8 | spread(se->cells) << 10;
+    }
+    this->nodes.push_back({nw, ne, sw, se, this->buckets[bucket],
+        nw->level + 1, nw->population + ne->population + sw->population
+        + se->population, nullptr, -1, cells});
+    Node* node = &this->nodes.back();
+    this->buckets[bucket] = node;
+    return node;
+}
+
+HashLifeSimulator::Node* HashLifeSimulator::getEmptyNode(const int level) {
+    while ((int) this->emptyNodes.size() <= level) {
+        Node* below = this->emptyNodes.back();
+        this->emptyNodes.push_back(this->getNode(below, below, below, below));
+    }
+    return this->emptyNodes[level];
+}
+
+HashLifeSimulator::Node* HashLifeSimulator::centerNode(Node* node) {
+    return this->getNode(node->nw->se, node->ne->sw, node->sw->ne,
+            node->se->nw);
+}
+
+HashLifeSimulator::Node* HashLifeSimulator::expandNode(Node* node) {
+    // same block in the middle of one twice the size
+    Node* empty = this->getEmptyNode(node->level - 1);
+    return this->getNode(this->getNode(empty, empty, empty, node->nw),
+            this->getNode(empty, empty, node->ne, empty),
+            this->getNode(empty, node->sw, empty, empty),
+            this->getNode(node->se, empty, empty, empty));
+}
+
+bool HashLifeSimulator::centerHolds(const Node* node) const {
+    return node->nw->se->population + node->ne->sw->population
+            + node->sw->ne->population + node->se->nw->population
+            == node->population;
+}
+
+void HashLifeSimulator::shrinkRoot() {
+    // keeping the root as small as it can be means the same universe always
+    // has the same root
+    while (this->root->level > minRootLevel && this->centerHolds(this->root)) {
+        this->root = this->centerNode(this->root);
+    }
+}
+
+HashLifeSimulator::Node* HashLifeSimulator::advanceNode(Node* node,
+        const int stepLog, const int parity) {
+    // the parity only matters if the rule alternates, leaving it out
+    // otherwise lets both parities share the results
+    const int p = this->alternating() ? parity : 0;
+    const int key = stepLog * 2 + p;
+    if (node->population == 0)
+        return this->getEmptyNode(node->level - 1);
+    if (node->resultKey == key)
+        return node->result;
+    Node* result;
+    if (node->level == 2) {
+        result = this->stepLeafBlock(node, p);
+    } else {
+        // the 9 overlapping blocks of half the size covering the node
+        Node* sub[3][3] = {
+            {node->nw, this->getNode(node->nw->ne, node->ne->nw, node->nw->se,
+                node->ne->sw), node->ne},
+            {this->getNode(node->nw->sw, node->nw->se, node->sw->nw,
+                node->sw->ne), this->centerNode(node),
+                this->getNode(node->ne->sw, node->ne->se, node->se->nw,
+                node->se->ne)},
+            {node->sw, this->getNode(node->sw->ne, node->se->nw, node->sw->se,
+                node->se->sw), node->se}
+        };
+        // at full speed both halves advance 2^(stepLog - 1) generations,
+        // slower steps only advance in the second half and just take the
+        // centers of the 9 blocks in the first
+        const bool fullSpeed = stepLog == node->level - 2;
+        const int halfLog = fullSpeed ? stepLog - 1 : stepLog;
+        Node* mid[3][3];
+        for (int row = 0; row < 3; row++) {
+            for (int col = 0; col < 3; col++) {
+                mid[row][col] = fullSpeed
+                        ? this->advanceNode(sub[row][col], halfLog, p)
+                        : this->centerNode(sub[row][col]);
+            }
+        }
+        const int midParity = fullSpeed && halfLog == 0 ? p ^ 1 : p;
+        Node* quadrants[2][2];
+        for (int row = 0; row < 2; row++) {
+            for (int col = 0; col < 2; col++) {
+                quadrants[row][col] = this->advanceNode(this->getNode(
+                        mid[row][col], mid[row][col + 1], mid[row + 1][col],
+                        mid[row + 1][col + 1]), halfLog, midParity);
+            }
+        }
+        result = this->getNode(quadrants[0][0], quadrants[0][1],
+                quadrants[1][0], quadrants[1][1]);
+    }
+    node->result = result;
+    node->resultKey = key;
+    return result;
+}
+
+HashLifeSimulator::Node* HashLifeSimulator::stepLeafBlock(Node* node,
+        const int parity) {
+    const uint8_t center = this->leafSteps[parity][node->cells];
+    Node* const leaves[2] = {this->deadCell, this->aliveCell};
+    return this->getNode(leaves[center & 1], leaves[(center >> 1) & 1],
+            leaves[(center >> 2) & 1], leaves[(center >> 3) & 1]);
+}
+
+HashLifeSimulator::Node* HashLifeSimulator::buildNode(
+        const GenerationFrame& frame, const int level,
+        const long long int blockX, const long long int blockY) {
+    const long long int size = 1LL << level;
+    if (blockX >= frame.x + frame.width || blockX + size <= frame.x
+            || blockY >= frame.y + frame.height || blockY + size <= frame.y)
+        return this->getEmptyNode(level);
+    if (level == 0) {
+        return frame.getCellVal(blockX, blockY) ? this->aliveCell
+                : this->deadCell;
+    }
+    const long long int half = size / 2;
+    return this->getNode(this->buildNode(frame, level - 1, blockX, blockY),
+            this->buildNode(frame, level - 1, blockX + half, blockY),
+            this->buildNode(frame, level - 1, blockX, blockY + half),
+            this->buildNode(frame, level - 1, blockX + half, blockY + half));
+}
+
+void HashLifeSimulator::advancePow2(const int stepLog) {
+    // the pattern has to sit in the center half of a block at least
+    // 2^(stepLog + 2) wide, then one more ring of empty space makes sure
+    // nothing can grow past the center of the block that is advanced
+    while (this->root->level < stepLog + 2 || !this->centerHolds(this->root)) {
+        this->root = this->expandNode(this->root);
+    }
+    this->root = this->expandNode(this->root);
+    this->root = this->advanceNode(this->root, stepLog, this->generation % 2);
+    this->generation += (int) (1LL << stepLog);
+    this->shrinkRoot();
+}
+
+void HashLifeSimulator::advanceKeeping(const long long int genCount,
+        const std::vector<Node**>& roots) {
+    // largest jumps first, the big nodes they make are the ones most likely
+    // to be reused by later jumps
+    for (int stepLog = 62; stepLog >= 0; stepLog--) {
+        if (!((genCount >> stepLog) & 1))
+            continue;
+        if (this->nodes.size() > maxNodeCount)
+            this->collectGarbage(roots);
+        this->advancePow2(stepLog);
+    }
+}
+
+void HashLifeSimulator::step() {
+    this->advance(1);
+}
+
+void HashLifeSimulator::advance(const long long int genCount) {
+    this->advanceKeeping(genCount, {});
+}
+
+int HashLifeSimulator::advanceUnlessSettled(const int targetGen) {
+    if (this->alternating())
+        return SimulationEngine::advanceUnlessSettled(targetGen);
+    if (this->empty())
+        return this->generation;
+    // every generation up to checkpointGen is known to not have stopped
+    Node* checkpoint = this->root;
+    int checkpointGen = this->generation;
+    Node* previous = nullptr;
+    // lands jumpLength generations after the checkpoint, one step at the end
+    // to see the generation before it. Returns true if it has stopped there
+    auto land = [&](const int jumpLength) {
+        this->root = checkpoint;
+        this->generation = checkpointGen;
+        this->advanceKeeping(jumpLength - 1, {&checkpoint});
+        previous = this->root;
+        this->advanceKeeping(1, {&checkpoint, &previous});
+        return this->settledSince(previous);
+    };
+    long long int jumpLength = 1;
+    while (checkpointGen < targetGen) {
+        const int landGen = (int) std::min<long long int>(targetGen,
+                checkpointGen + jumpLength);
+        if (land(landGen - checkpointGen)) {
+            // first generation that stopped is in (checkpointGen, landGen]
+            int stoppedGen = landGen;
+            while (stoppedGen - checkpointGen > 1) {
+                const int midGen = checkpointGen
+                        + (stoppedGen - checkpointGen) / 2;
+                if (land(midGen - checkpointGen)) {
+                    stoppedGen = midGen;
+                } else {
+                    checkpoint = this->root;
+                    checkpointGen = midGen;
+                }
+            }
+            if (this->generation != stoppedGen)
+                land(stoppedGen - checkpointGen);
+            return stoppedGen;
+        }
+        checkpoint = this->root;
+        checkpointGen = landGen;
+        jumpLength *= 2;
+    }
+    return -1;
+}
+
+bool HashLifeSimulator::settledSince(Node* previousRoot) const {
+    if (this->root->population == 0)
+        return true;
+    if (this->root->population != previousRoot->population)
+        return false;
+    // the root is as small as it can be so the same universe means the
+    // same root
+    if (this->root == previousRoot)
+        return true;
+    return this->frameOf(this->root).sameShape(this->frameOf(previousRoot));
+}
+
+bool HashLifeSimulator::empty() const {
+    return this->root->population == 0;
+}
+
+long long int HashLifeSimulator::getPopulation() const {
+    return this->root->population;
+}
+
+GenerationFrame HashLifeSimulator::getFrame() const {
+    return this->frameOf(this->root);
+}
+
+GenerationFrame HashLifeSimulator::frameOf(const Node* universe) const {
+    GenerationFrame frame;
+    if (universe->population == 0)
+        return frame;
+    std::vector<std::pair<long long int, long long int>> cells;
+    cells.reserve(universe->population);
+    const long long int half = 1LL << (universe->level - 1);
+    this->collectCells(universe, -half, -half, cells);
+    long long int minX = cells[0].first;
+    long long int maxX = cells[0].first;
+    long long int minY = cells[0].second;
+    long long int maxY = cells[0].second;
+    for (auto& cell : cells) {
+        minX = std::min(minX, cell.first);
+        maxX = std::max(maxX, cell.first);
+        minY = std::min(minY, cell.second);
+        maxY = std::max(maxY, cell.second);
+    }
+    frame.resize(minX, minY, maxX - minX + 1, maxY - minY + 1);
+    for (auto& cell : cells) {
+        frame.setCellVal(cell.first, cell.second, true);
+    }
+    return frame;
+}
+
+void HashLifeSimulator::collectCells(const Node* node,
+        const long long int nodeX, const long long int nodeY,
+        std::vector<std::pair<long long int, long long int>>& cells) const {
+    if (node->population == 0)
+        return;
+    if (node->level == 0) {
+        cells.emplace_back(nodeX, nodeY);
+        return;
+    }
+    const long long int half = 1LL << (node->level - 1);
+    this->collectCells(node->nw, nodeX, nodeY, cells);
+    this->collectCells(node->ne, nodeX + half, nodeY, cells);
+    this->collectCells(node->sw, nodeX, nodeY + half, cells);
+    this->collectCells(node->se, nodeX + half, nodeY + half, cells);
+}
+
+void HashLifeSimulator::collectGarbage(const std::vector<Node**>& roots) {
+    // build a new table out of just the nodes still used, the old nodes
+    // stay around until everything has been copied over
+    std::deque<Node> oldNodes;
+    oldNodes.swap(this->nodes);
+    this->makeLeaves();
+    std::unordered_map<const Node*, Node*> copies;
+    this->root = this->copyNode(this->root, copies);
+    for (Node** kept : roots) {
+        *kept = this->copyNode(*kept, copies);
+    }
+}
+
+HashLifeSimulator::Node* HashLifeSimulator::copyNode(const Node* node,
+        std::unordered_map<const Node*, Node*>& copies) {
+    if (node->level == 0)
+        return node->population != 0 ? this->aliveCell : this->deadCell;
+    auto found = copies.find(node);
+    if (found != std::end(copies))
+        return found->second;
+    Node* copy = this->getNode(this->copyNode(node->nw, copies),
+            this->copyNode(node->ne, copies), this->copyNode(node->sw, copies),
+            this->copyNode(node->se, copies));
+    copies.emplace(node, copy);
+    return copy;
+}
+
+#endif /* HASH_LIFE_SIMULATOR_CPP */
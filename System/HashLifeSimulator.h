@@ -0,0 +1,165 @@
+/*
+ * File:   HashLifeSimulator.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef HASH_LIFE_SIMULATOR_H
+#define HASH_LIFE_SIMULATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include "GenerationFrame.h"
+#include "SimulationEngine.h"
+
+// Hashlife simulation engine for long runs and patterns that grow far past
+// the soup. The universe is a quadtree where every distinct block of cells
+// is only stored once, and every block remembers what its center looks like
+// some number of generations later, so repeating parts of a pattern (still
+// lifes, oscillators, gliders flying through empty space) are only ever
+// simulated once. Generations the caller doesn't need to see are skipped
+// with jumps of a power of two generations instead of being stepped one at
+// a time.
+class HashLifeSimulator : public SimulationEngine {
+public:
+    // constructor
+    // same as LifeSimulator, the same chromosome and seed give the same soup
+    HashLifeSimulator(const std::string& chromosome, const int gridSize,
+            const int fillPercent, const unsigned int seed);
+
+    // advances the pattern by one generation
+    void step() override;
+
+    // advances the pattern by genCount generations at once
+    void advance(const long long int genCount);
+
+    // true if there are no live cells left
+    bool empty() const override;
+
+    // returns the current generation cropped to the live cells
+    GenerationFrame getFrame() const override;
+
+    // returns the number of live cells
+    long long int getPopulation() const;
+
+protected:
+    // jumps ahead and only looks at where it lands. Dying out and stopping
+    // to change can't be undone, so once a jump lands on a generation that
+    // has stopped it is bisected from where it started to find the first
+    // one. With alternating rules a pattern can match the one before it
+    // without staying that way, so every generation is looked at
+    int advanceUnlessSettled(const int targetGen) override;
+
+private:
+    // a square block of 2^level x 2^level cells, level 0 being a single
+    // cell. Nodes are never changed after they are made and there is only
+    // ever one node for every distinct block so nodes can be compared by
+    // address
+    struct Node {
+        Node* nw;
+        Node* ne;
+        Node* sw;
+        Node* se;
+        Node* next; // next node in the same bucket of the node table
+        int level;
+        long long int population;
+        // last center of the block worked out by advanceNode
+        Node* result;
+        int resultKey; // stepLog * 2 + parity the result is for, -1 if none
+        // level 2 and below only: bit (4 * y + x) is the cell at (x, y)
+        uint16_t cells;
+    };
+
+    // more nodes than this makes the next jump start with a collection
+    static const size_t maxNodeCount = 1 << 22;
+    // the root is never made smaller than this
+    static const int minRootLevel = 3;
+
+    std::deque<Node> nodes; // deque so nodes never move
+    // hash table of every node by its children, chained through Node::next
+    std::vector<Node*> buckets;
+    // the 2x2 center of every 4x4 block one generation later, indexed by
+    // Node::cells, for even and odd generations
+    uint8_t leafSteps[2][1 << 16];
+    Node* deadCell;
+    Node* aliveCell;
+    std::vector<Node*> emptyNodes; // empty node of every level made so far
+    // the universe spans -2^(level - 1) to 2^(level - 1) - 1 on both axes
+    Node* root;
+
+    // makes the two level 0 nodes
+    void makeLeaves();
+
+    // fills leafSteps for both parities
+    void makeLeafSteps();
+
+    // returns the bucket of the node table the given children belong in
+    size_t getBucket(const Node* nw, const Node* ne, const Node* sw,
+            const Node* se) const;
+
+    // returns the node with the given children, making it if it's new
+    Node* getNode(Node* nw, Node* ne, Node* sw, Node* se);
+
+    // returns the node with every cell dead of the given level
+    Node* getEmptyNode(const int level);
+
+    // returns the block of half the size at the center of node
+    Node* centerNode(Node* node);
+
+    // returns the block of twice the size with node at its center
+    Node* expandNode(Node* node);
+
+    // true if every live cell of node is in its center half
+    bool centerHolds(const Node* node) const;
+
+    // makes the root as small as it can be without losing live cells
+    void shrinkRoot();
+
+    // returns the center of node 2^stepLog generations later, stepLog can be
+    // at most node->level - 2. parity is the generation % 2 the node is at
+    Node* advanceNode(Node* node, const int stepLog, const int parity);
+
+    // steps a 4x4 block one generation and returns its 2x2 center
+    Node* stepLeafBlock(Node* node, const int parity);
+
+    // returns the node of the given level whose top left cell is at
+    // (blockX, blockY), taking the cells from the frame
+    Node* buildNode(const GenerationFrame& frame, const int level,
+            const long long int blockX, const long long int blockY);
+
+    // advances the universe by 2^stepLog generations
+    void advancePow2(const int stepLog);
+
+    // advances the universe by genCount generations, collecting garbage
+    // along the way if there are too many nodes. The roots given are kept
+    // by the collection on top of the universe itself and point to the
+    // copies afterwards
+    void advanceKeeping(const long long int genCount,
+            const std::vector<Node**>& roots);
+
+    // true if the universe is empty or has the same shape as previousRoot,
+    // the universe a generation before
+    bool settledSince(Node* previousRoot) const;
+
+    // returns the cells of a universe cropped to its live cells
+    GenerationFrame frameOf(const Node* universe) const;
+
+    // adds the world coordinates of every live cell of node, which has its
+    // top left cell at (nodeX, nodeY), to cells
+    void collectCells(const Node* node, const long long int nodeX,
+            const long long int nodeY,
+            std::vector<std::pair<long long int, long long int>>& cells) const;
+
+    // throws away every node that neither the universe nor the given roots
+    // use, the results remembered by the nodes kept are thrown away as well
+    void collectGarbage(const std::vector<Node**>& roots);
+
+    // copies node over into the node table being built by collectGarbage
+    Node* copyNode(const Node* node,
+            std::unordered_map<const Node*, Node*>& copies);
+};
+
+#endif /* HASH_LIFE_SIMULATOR_H */
@@ -0,0 +1,100 @@
+#ifndef INSTRUMENTATION_CPP
+#define INSTRUMENTATION_CPP
+
+/*
+ * File:   Instrumentation.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <string>
+#include <cstdio>
+#include "Instrumentation.h"
+
+void instrument::Record::add(const std::string& name,
+        const std::string& value) {
+    this->fields.push_back({name, value, true});
+}
+
+void instrument::Record::add(const std::string& name, const char* value) {
+    this->add(name, std::string(value));
+}
+
+void instrument::Record::add(const std::string& name, const double value) {
+    char text[32];
+    std::snprintf(text, sizeof (text), "%.9g", value);
+    this->fields.push_back({name, text, false});
+}
+
+void instrument::Record::add(const std::string& name, const long long value) {
+    this->fields.push_back({name, std::to_string(value), false});
+}
+
+void instrument::Record::add(const std::string& name, const int value) {
+    this->add(name, (long long) value);
+}
+
+void instrument::Record::add(const std::string& prefix,
+        const Counters& counters) {
+    this->add(prefix + "bytesRead", counters.bytesRead.load());
+    this->add(prefix + "filesOpened", counters.filesOpened.load());
+    this->add(prefix + "cellsSet", counters.cellsSet.load());
+    this->add(prefix + "boardBytes", counters.boardBytes.load());
+}
+
+std::string instrument::Record::toJson() const {
+    std::string json = "{";
+    for (size_t i = 0; i < this->fields.size(); i++) {
+        const Field& field = this->fields[i];
+        if (i > 0)
+            json += ",";
+        json += "\"" + field.name + "\":";
+        if (!field.quoted) {
+            // JSON has no nan or inf, the stats of class 1 and 2 are nan
+            const bool finite = field.value.find_first_of("ni")
+                    == std::string::npos;
+            json += finite ? field.value : "null";
+            continue;
+        }
+        json += "\"";
+        for (char c : field.value) {
+            if (c == '"' || c == '\\')
+                json += '\\';
+            json += c;
+        }
+        json += "\"";
+    }
+    return json + "}";
+}
+
+std::string instrument::Record::csvHeader() const {
+    std::string csv;
+    for (size_t i = 0; i < this->fields.size(); i++) {
+        if (i > 0)
+            csv += ",";
+        csv += this->fields[i].name;
+    }
+    return csv;
+}
+
+std::string instrument::Record::toCsv() const {
+    std::string csv;
+    for (size_t i = 0; i < this->fields.size(); i++) {
+        const Field& field = this->fields[i];
+        if (i > 0)
+            csv += ",";
+        if (field.quoted && field.value.find_first_of(",\"") != std::string::npos) {
+            csv += "\"";
+            for (char c : field.value) {
+                if (c == '"')
+                    csv += '"';
+                csv += c;
+            }
+            csv += "\"";
+        } else
+            csv += field.value;
+    }
+    return csv;
+}
+
+#endif /* INSTRUMENTATION_CPP */
@@ -0,0 +1,114 @@
+/*
+ * File:   Instrumentation.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+
+// Timers and counters of where the time of a classification or a GA
+// generation goes. They are only kept in builds with CAGA_INSTRUMENT
+// defined: without it CAGA_TIME and CAGA_COUNT expand to nothing (the
+// amounts counted aren't even worked out) and instrument::enabled is false,
+// so code guarded by it is compiled away.
+namespace instrument {
+#ifdef CAGA_INSTRUMENT
+    constexpr bool enabled = true;
+#else
+    constexpr bool enabled = false;
+#endif
+
+    // work done by a classifier, added to by several threads at once
+    struct Counters {
+        std::atomic<long long> bytesRead{0}; // of .rle files and dumps
+        std::atomic<long long> filesOpened{0};
+        std::atomic<long long> cellsSet{0}; // live cells of every generation
+        std::atomic<long long> boardBytes{0}; // memory allocated for boards
+
+        // adds every counter of other to these
+        void add(const Counters& other) {
+            this->bytesRead += other.bytesRead;
+            this->filesOpened += other.filesOpened;
+            this->cellsSet += other.cellsSet;
+            this->boardBytes += other.boardBytes;
+        }
+
+        // sets every counter back to 0
+        void reset() {
+            this->bytesRead = 0;
+            this->filesOpened = 0;
+            this->cellsSet = 0;
+            this->boardBytes = 0;
+        }
+    };
+
+    // adds the wall time in seconds from its construction to its
+    // destruction to seconds
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(double& seconds) : seconds(seconds),
+                start(std::chrono::steady_clock::now()) {
+        }
+
+        ~ScopedTimer() {
+            this->seconds += std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - this->start).count();
+        }
+
+    private:
+        double& seconds;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // one line of output, a list of named values that is written either as
+    // a JSON object or as a CSV row (with csvHeader giving the names)
+    class Record {
+    public:
+        // adds a value, strings are quoted in JSON
+        void add(const std::string& name, const std::string& value);
+        void add(const std::string& name, const char* value);
+        void add(const std::string& name, const double value);
+        void add(const std::string& name, const long long value);
+        void add(const std::string& name, const int value);
+
+        // adds the four counters, each named prefix + counter
+        void add(const std::string& prefix, const Counters& counters);
+
+        std::string toJson() const;
+        std::string csvHeader() const;
+        std::string toCsv() const;
+
+    private:
+        // name, value as written and whether it is a string
+        struct Field {
+            std::string name;
+            std::string value;
+            bool quoted;
+        };
+        std::vector<Field> fields;
+    };
+}
+
+#define CAGA_CONCAT_INNER(a, b) a##b
+#define CAGA_CONCAT(a, b) CAGA_CONCAT_INNER(a, b)
+
+#ifdef CAGA_INSTRUMENT
+// times the rest of the enclosing scope, adding it to the double seconds
+#define CAGA_TIME(seconds) \
+    instrument::ScopedTimer CAGA_CONCAT(cagaTimer, __LINE__)(seconds)
+// adds amount to one of the atomic counters of instrument::Counters
+#define CAGA_COUNT(counter, amount) \
+    (counter).fetch_add((amount), std::memory_order_relaxed)
+#else
+#define CAGA_TIME(seconds) do {} while (0)
+#define CAGA_COUNT(counter, amount) do {} while (0)
+#endif
+
+#endif /* INSTRUMENTATION_H */
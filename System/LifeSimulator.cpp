@@ -0,0 +1,242 @@
+#ifndef LIFE_SIMULATOR_CPP
+#define LIFE_SIMULATOR_CPP
+
+/*
+ * File:   LifeSimulator.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "LifeSimulator.h"
+#include "RuleKernels.h"
+
+LifeSimulator::LifeSimulator(const std::string& chromosome,
+        const int gridSize, const int fillPercent, const unsigned int seed)
+        : SimulationEngine(chromosome) {
+    // leave a word of dead cells on the left and right and some rows above
+    // and below so the soup has room to grow before the grid is resized
+    this->wordsPerRow = (gridSize + 63) / 64 + 2;
+    this->gridWidth = this->wordsPerRow * 64;
+    this->gridHeight = gridSize + 64;
+    this->originX = -64;
+    this->originY = -32;
+    this->cells.assign(static_cast<size_t> (this->wordsPerRow)
+            * this->gridHeight, 0);
+    this->nextCells.assign(this->cells.size(), 0);
+    this->fillSoup(gridSize, fillPercent, seed, [&](const int x, const int y) {
+        int gridX = x - this->originX;
+        this->cells[static_cast<size_t> (y - this->originY) * this->wordsPerRow
+                + gridX / 64] |= uint64_t(1) << (gridX % 64);
+    });
+    this->cellsBox.minWord = 0;
+    this->cellsBox.maxWord = this->wordsPerRow - 1;
+    this->cellsBox.minRow = -this->originY;
+    this->cellsBox.maxRow = -this->originY + gridSize - 1;
+    this->findBoundingBox();
+}
+
+LifeSimulator::LifeSimulator(const std::string& chromosome,
+        const GenerationFrame& frame, const int generation)
+        : SimulationEngine(chromosome) {
+    // same room around the pattern as around the soup
+    this->wordsPerRow = frame.wordsPerRow + 2;
+    this->gridWidth = this->wordsPerRow * 64;
+    this->gridHeight = frame.height + 64;
+    this->originX = frame.x - 64;
+    this->originY = frame.y - 32;
+    this->cells.assign(static_cast<size_t> (this->wordsPerRow)
+            * this->gridHeight, 0);
+    this->nextCells.assign(this->cells.size(), 0);
+    for (int r = 0; r < frame.height; r++) {
+        std::copy(frame.row(r), frame.row(r) + frame.wordsPerRow,
+                this->cells.data() + static_cast<size_t> (r + 32)
+                * this->wordsPerRow + 1);
+    }
+    this->cellsBox.minWord = 1;
+    this->cellsBox.maxWord = frame.wordsPerRow;
+    this->cellsBox.minRow = 32;
+    this->cellsBox.maxRow = 32 + frame.height - 1;
+    this->generation = generation;
+    this->findBoundingBox();
+}
+
+void LifeSimulator::step() {
+    if (!this->alive) {
+        this->generation++;
+        return;
+    }
+    this->ensureMargin();
+    const bool oddGen = this->generation % 2 == 1;
+    const uint16_t birth = oddGen ? this->oddBirth : this->evenBirth;
+    const uint16_t survive = oddGen ? this->oddSurvive : this->evenSurvive;
+    // clear whatever is left in the buffer from two generations ago
+    for (int y = this->nextBox.minRow; y <= this->nextBox.maxRow; y++) {
+        uint64_t* gridRow = this->nextCells.data()
+                + static_cast<size_t> (y) * this->wordsPerRow;
+        std::fill(gridRow + this->nextBox.minWord,
+                gridRow + this->nextBox.maxWord + 1, 0);
+    }
+    // new live cells can only show up one cell outside the current box
+    WordBox written;
+    written.minRow = this->minY - 1;
+    written.maxRow = this->maxY + 1;
+    written.minWord = (this->minX - 1) / 64;
+    written.maxWord = (this->maxX + 1) / 64;
+    // the rule is a template argument of the loop so hot rules get a
+    // kernel of their own, see rulekernels::dispatch
+    rulekernels::dispatch(birth, survive, [&](const auto& rule) {
+        this->stepWords(written, rule);
+    });
+    std::swap(this->cells, this->nextCells);
+    this->nextBox = this->cellsBox;
+    this->cellsBox = written;
+    this->generation++;
+    this->findBoundingBox();
+}
+
+template <typename Rule>
+void LifeSimulator::stepWords(const WordBox& written, const Rule& rule) {
+    const std::vector<uint64_t> zeroRow(this->wordsPerRow, 0);
+    auto gridRow = [&](const int y) {
+        if (y < 0 || y >= this->gridHeight)
+            return zeroRow.data();
+        return static_cast<const uint64_t*> (this->cells.data()
+                + static_cast<size_t> (y) * this->wordsPerRow);
+    };
+    for (int y = written.minRow; y <= written.maxRow; y++) {
+        const uint64_t* rows[3] = {gridRow(y - 1), gridRow(y), gridRow(y + 1)};
+        uint64_t* outRow = this->nextCells.data()
+                + static_cast<size_t> (y) * this->wordsPerRow;
+        for (int w = written.minWord; w <= written.maxWord; w++) {
+            // gather the 8 neighbours of every cell in the word, shifted so
+            // that each one lines up with the cell it is a neighbour of
+            uint64_t n[8];
+            int count = 0;
+            for (int r = 0; r < 3; r++) {
+                uint64_t center = rows[r][w];
+                uint64_t left = w > 0 ? rows[r][w - 1] : 0;
+                uint64_t right = w + 1 < this->wordsPerRow ? rows[r][w + 1] : 0;
+                n[count++] = (center << 1) | (left >> 63); // west neighbour
+                n[count++] = (center >> 1) | (right << 63); // east neighbour
+                if (r != 1)
+                    n[count++] = center;
+            }
+            uint64_t planes[4];
+            rulekernels::countNeighbours(n, planes);
+            outRow[w] = rule(planes, rows[1][w]);
+        }
+    }
+}
+
+void LifeSimulator::ensureMargin() {
+    if (this->minX >= 1 && this->maxX <= this->gridWidth - 2
+            && this->minY >= 1 && this->maxY <= this->gridHeight - 2)
+        return;
+    // grow by half the size on every side, moving whole words so the copy
+    // does not have to shift any bits
+    const int padWords = std::max(1, this->wordsPerRow / 2);
+    const int padRows = std::max(32, this->gridHeight / 2);
+    const int newWordsPerRow = this->wordsPerRow + 2 * padWords;
+    const int newHeight = this->gridHeight + 2 * padRows;
+    std::vector<uint64_t> grown(static_cast<size_t> (newWordsPerRow)
+            * newHeight, 0);
+    for (int y = this->cellsBox.minRow; y <= this->cellsBox.maxRow; y++) {
+        const uint64_t* oldRow = this->cells.data()
+                + static_cast<size_t> (y) * this->wordsPerRow;
+        uint64_t* newRow = grown.data()
+                + static_cast<size_t> (y + padRows) * newWordsPerRow + padWords;
+        std::copy(oldRow + this->cellsBox.minWord,
+                oldRow + this->cellsBox.maxWord + 1,
+                newRow + this->cellsBox.minWord);
+    }
+    this->cells.swap(grown);
+    this->nextCells.assign(this->cells.size(), 0);
+    this->wordsPerRow = newWordsPerRow;
+    this->gridWidth = newWordsPerRow * 64;
+    this->gridHeight = newHeight;
+    this->originX -= padWords * 64;
+    this->originY -= padRows;
+    this->minX += padWords * 64;
+    this->maxX += padWords * 64;
+    this->minY += padRows;
+    this->maxY += padRows;
+    this->cellsBox.minWord += padWords;
+    this->cellsBox.maxWord += padWords;
+    this->cellsBox.minRow += padRows;
+    this->cellsBox.maxRow += padRows;
+    this->nextBox = WordBox();
+}
+
+void LifeSimulator::findBoundingBox() {
+    this->alive = false;
+    for (int y = this->cellsBox.minRow; y <= this->cellsBox.maxRow; y++) {
+        const uint64_t* gridRow = this->cells.data()
+                + static_cast<size_t> (y) * this->wordsPerRow;
+        int first = -1;
+        int last = -1;
+        for (int w = this->cellsBox.minWord; w <= this->cellsBox.maxWord; w++) {
+            if (gridRow[w] != 0) {
+                if (first == -1)
+                    first = w;
+                last = w;
+            }
+        }
+        if (first == -1)
+            continue;
+        int rowMin = first * 64 + __builtin_ctzll(gridRow[first]);
+        int rowMax = last * 64 + 63 - __builtin_clzll(gridRow[last]);
+        if (!this->alive) {
+            this->alive = true;
+            this->minY = y;
+            this->minX = rowMin;
+            this->maxX = rowMax;
+        } else {
+            this->minX = std::min(this->minX, rowMin);
+            this->maxX = std::max(this->maxX, rowMax);
+        }
+        this->maxY = y;
+    }
+}
+
+uint64_t LifeSimulator::readBits(const uint64_t* gridRow,
+        const long long int bitPos) const {
+    long long int word = bitPos / 64;
+    int shift = bitPos % 64;
+    if (word >= this->wordsPerRow)
+        return 0;
+    uint64_t bits = gridRow[word] >> shift;
+    if (shift != 0 && word + 1 < this->wordsPerRow)
+        bits |= gridRow[word + 1] << (64 - shift);
+    return bits;
+}
+
+bool LifeSimulator::empty() const {
+    return !this->alive;
+}
+
+GenerationFrame LifeSimulator::getFrame() const {
+    GenerationFrame frame;
+    if (!this->alive)
+        return frame;
+    frame.resize(this->originX + this->minX, this->originY + this->minY,
+            this->maxX - this->minX + 1, this->maxY - this->minY + 1);
+    // mask for the bits of the last word that are inside the frame
+    const int tailBits = frame.width % 64;
+    const uint64_t tailMask = tailBits == 0 ? ~uint64_t(0)
+            : (uint64_t(1) << tailBits) - 1;
+    for (int r = 0; r < frame.height; r++) {
+        const uint64_t* gridRow = this->cells.data()
+                + static_cast<size_t> (this->minY + r) * this->wordsPerRow;
+        uint64_t* frameRow = frame.row(r);
+        for (int w = 0; w < frame.wordsPerRow; w++) {
+            frameRow[w] = this->readBits(gridRow, this->minX + 64LL * w);
+        }
+        frameRow[frame.wordsPerRow - 1] &= tailMask;
+    }
+    return frame;
+}
+
+#endif /* LIFE_SIMULATOR_CPP */
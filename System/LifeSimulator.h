@@ -0,0 +1,86 @@
+/*
+ * File:   LifeSimulator.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef LIFE_SIMULATOR_H
+#define LIFE_SIMULATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GenerationFrame.h"
+#include "SimulationEngine.h"
+
+// Bit-packed simulation engine, used as the default in-process simulator.
+// Cells are bit-packed 64 to a word and a whole word of cells is advanced at
+// once by adding up the 8 neighbour bits with bit-sliced full adders, the
+// hot rules getting a kernel compiled for them (see RuleKernels.h). The grid
+// grows whenever the pattern gets close to its edge so the universe behaves as
+// if it were unbounded.
+class LifeSimulator : public SimulationEngine {
+public:
+    // constructor
+    // takes the 18 char chromosome used by the GA (first 9 genes are the birth
+    // conditions 0-8, last 9 genes are the survival conditions 0-8) and fills
+    // the gridSize x gridSize square at the origin with random soup, each cell
+    // being alive with a chance of fillPercent percent like g.randfill does.
+    // The same seed always gives the same soup.
+    LifeSimulator(const std::string& chromosome, const int gridSize,
+            const int fillPercent, const unsigned int seed);
+
+    // carries on with the pattern in frame, which is the given generation
+    // of the rule
+    LifeSimulator(const std::string& chromosome, const GenerationFrame& frame,
+            const int generation);
+
+    // advances the pattern by one generation
+    void step() override;
+
+    // true if there are no live cells left
+    bool empty() const override;
+
+    // returns the current generation cropped to the live cells
+    GenerationFrame getFrame() const override;
+
+private:
+    int originX; // world x-coord of the grid's column 0
+    int originY; // world y-coord of the grid's row 0
+    int gridWidth; // always a multiple of 64
+    int gridHeight;
+    int wordsPerRow;
+    std::vector<uint64_t> cells; // current generation
+    std::vector<uint64_t> nextCells; // buffer the next generation is built in
+    // bounding box of live cells in grid coordinates, only valid if alive
+    bool alive;
+    int minX, maxX, minY, maxY;
+
+    // describes the words of a buffer that may be non-zero, so only that
+    // part has to be cleared before the buffer is reused
+    struct WordBox {
+        int minWord = 0;
+        int maxWord = -1;
+        int minRow = 0;
+        int maxRow = -1;
+    };
+    WordBox cellsBox;
+    WordBox nextBox;
+
+    // writes the next generation of the words in written into nextCells,
+    // rule being one of the kernels of RuleKernels.h
+    template <typename Rule>
+    void stepWords(const WordBox& written, const Rule& rule);
+
+    // makes the grid bigger if live cells are within one cell of its edge
+    // so the next generation is guaranteed to fit
+    void ensureMargin();
+
+    // scans the current generation and updates the bounding box
+    void findBoundingBox();
+
+    // reads 64 bits of a grid row starting at the given bit
+    uint64_t readBits(const uint64_t* gridRow, const long long int bitPos) const;
+};
+
+#endif /* LIFE_SIMULATOR_H */
@@ -0,0 +1,68 @@
+/*
+ * File:   ParallelFor.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <exception>
+#include <mutex>
+#include <algorithm>
+
+// Runs task(i) for every i in [0, taskCount) on up to maxThrNum threads,
+// the calling thread being one of them. Instead of handing every thread a
+// fixed range up front, threads take the next task off a shared atomic
+// counter whenever they finish one, so a few expensive tasks (dense
+// generations, say) don't leave the other threads idle. Works for any
+// thread count, extra threads are simply not started. If any task throws,
+// the remaining tasks are skipped and the first exception is rethrown once
+// every thread has stopped.
+inline void parallelFor(const int taskCount, const int maxThrNum,
+        const std::function<void(const int)>& task) {
+    if (taskCount <= 0)
+        return;
+    const int thrNum = std::max(1, std::min(maxThrNum, taskCount));
+    if (thrNum == 1) {
+        for (int i = 0; i < taskCount; i++) {
+            task(i);
+        }
+        return;
+    }
+    std::atomic<int> nextTask(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr firstError;
+    std::mutex errorLock;
+    auto worker = [&]() {
+        while (!failed.load(std::memory_order_relaxed)) {
+            const int i = nextTask.fetch_add(1, std::memory_order_relaxed);
+            if (i >= taskCount)
+                return;
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(errorLock);
+                if (!firstError)
+                    firstError = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> threadList;
+    for (int t = 1; t < thrNum; t++) {
+        threadList.push_back(std::thread(worker));
+    }
+    worker();
+    for (auto& thr : threadList) {
+        thr.join();
+    }
+    if (firstError)
+        std::rethrow_exception(firstError);
+}
+
+#endif /* PARALLEL_FOR_H */
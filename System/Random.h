@@ -0,0 +1,83 @@
+/*
+ * File:   Random.h
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+// xoshiro256** random number generator (Blackman and Vigna), used to breed
+// the GA's Population. It is several times faster than std::mt19937, its
+// whole state is four words so it fits in a checkpoint, and it can be used
+// with the <random> distributions like any standard generator
+class Xoshiro256 {
+public:
+    typedef uint64_t result_type;
+
+    // constructor
+    explicit Xoshiro256(const uint64_t seed = 1) {
+        this->seed(seed);
+    }
+
+    // fills the state from seed with splitmix64, which the authors suggest
+    // so that similar seeds still give unrelated sequences
+    void seed(uint64_t seed) {
+        for (int i = 0; i < 4; i++) {
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            this->state[i] = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~uint64_t(0);
+    }
+
+    result_type operator()() {
+        const uint64_t result = rotl(this->state[1] * 5, 7) * 9;
+        const uint64_t t = this->state[1] << 17;
+        this->state[2] ^= this->state[0];
+        this->state[3] ^= this->state[1];
+        this->state[1] ^= this->state[2];
+        this->state[0] ^= this->state[3];
+        this->state[2] ^= t;
+        this->state[3] = rotl(this->state[3], 45);
+        return result;
+    }
+
+    // returns a number from 0 to range - 1, scaling the top 32 bits with a
+    // multiply instead of taking a modulo
+    uint32_t below(const uint32_t range) {
+        return (uint32_t) (((*this)() >> 32) * range >> 32);
+    }
+
+    // writes and reads the state as four numbers separated by spaces
+    friend std::ostream& operator<<(std::ostream& out, const Xoshiro256& rng) {
+        return out << rng.state[0] << " " << rng.state[1] << " "
+                << rng.state[2] << " " << rng.state[3];
+    }
+
+    friend std::istream& operator>>(std::istream& in, Xoshiro256& rng) {
+        return in >> rng.state[0] >> rng.state[1] >> rng.state[2]
+                >> rng.state[3];
+    }
+
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(const uint64_t x, const int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+#endif /* RANDOM_H */
@@ -0,0 +1,222 @@
+#ifndef REMOTE_WORKERS_CPP
+#define REMOTE_WORKERS_CPP
+
+/*
+ * File:   RemoteWorkers.cpp
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "RemoteWorkers.h"
+
+// opens a TCP connection to "host:port", -1 if it can't
+static int connectTo(const std::string& address) {
+    const size_t colon = address.rfind(':');
+    if (colon == std::string::npos)
+        return -1;
+    const std::string host = address.substr(0, colon);
+    const std::string port = address.substr(colon + 1);
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof (hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0)
+        return -1;
+    int fd = -1;
+    for (addrinfo* a = found; a != nullptr && fd == -1; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd != -1 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    if (fd != -1) {
+        // every message is a single line waited on, so don't hold it back
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof (on));
+    }
+    return fd;
+}
+
+RemoteWorkers::RemoteWorkers(const std::vector<std::string>& addresses,
+        const std::string& params) {
+    this->openCount = 0;
+    for (const std::string& address : addresses) {
+        Connection c;
+        c.address = address;
+        c.fd = connectTo(address);
+        std::string reply;
+        if (c.fd == -1 || !sendLine(c.fd, "PARAMS " + params)
+                || !readLine(c.fd, c.buffer, reply) || reply != "OK") {
+            fprintf(stderr, "Worker %s: %s\n", address.c_str(),
+                    c.fd == -1 ? "could not connect" : reply.c_str());
+            if (c.fd != -1)
+                close(c.fd);
+            for (Connection& open : this->connections) {
+                close(open.fd);
+            }
+            throw "Could not connect to every worker";
+        }
+        this->idle.push_back(this->connections.size());
+        this->connections.push_back(c);
+        this->openCount++;
+    }
+}
+
+RemoteWorkers::~RemoteWorkers() {
+    for (Connection& c : this->connections) {
+        if (c.fd != -1)
+            close(c.fd);
+    }
+}
+
+RuleMetrics RemoteWorkers::evaluate(const std::string& chromosome,
+        const int gen, const int soup) {
+    const std::string request = "EVAL " + std::to_string(gen) + " "
+            + std::to_string(soup) + " " + chromosome;
+    while (true) {
+        size_t i;
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+            this->idleReady.wait(guard, [this]() {
+                return !this->idle.empty() || this->openCount == 0;
+            });
+            if (this->openCount == 0)
+                throw "No workers left";
+            i = this->idle.back();
+            this->idle.pop_back();
+        }
+        // only this thread uses the connection until it is idle again
+        Connection& c = this->connections[i];
+        std::string reply;
+        const bool answered = sendLine(c.fd, request)
+                && readLine(c.fd, c.buffer, reply);
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (!answered) {
+            fprintf(stderr, "Worker %s: connection lost\n", c.address.c_str());
+            close(c.fd);
+            c.fd = -1;
+            this->openCount--;
+            this->idleReady.notify_all();
+            continue;
+        }
+        this->idle.push_back(i);
+        this->idleReady.notify_one();
+        RuleMetrics metrics;
+        const char* text = reply.c_str();
+        char* end;
+        metrics.aliveCell = strtod(text, &end);
+        metrics.percentChange = strtod(end, &end);
+        metrics.activeCell = strtod(end, &end);
+        const long classNum = strtol(end, &end, 10);
+        if (reply.compare(0, 4, "ERR ") == 0 || end == text
+                || classNum < 0 || classNum > 3) {
+            fprintf(stderr, "Worker %s: %s\n", c.address.c_str(), reply.c_str());
+            throw "A worker could not evaluate a Ruleset";
+        }
+        metrics.classNum = classNum;
+        return metrics;
+    }
+}
+
+int RemoteWorkers::size() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->openCount;
+}
+
+bool RemoteWorkers::sendLine(const int fd, const std::string& line) {
+    const std::string message = line + "\n";
+    size_t sent = 0;
+    while (sent < message.length()) {
+        const ssize_t n = send(fd, message.data() + sent,
+                message.length() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+bool RemoteWorkers::readLine(const int fd, std::string& buffer,
+        std::string& line) {
+    size_t end;
+    while ((end = buffer.find('\n')) == std::string::npos) {
+        char chunk[4096];
+        const ssize_t n = recv(fd, chunk, sizeof (chunk), 0);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, n);
+    }
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return true;
+}
+
+void RemoteWorkers::serve(const int port,
+        const std::function<std::string(const std::string&, std::string&)>& handle,
+        const std::function<void(const std::string&)>& onClose) {
+    const int listener = socket(AF_INET6, SOCK_STREAM, 0);
+    if (listener == -1)
+        throw "Could not listen for the coordinator";
+    int on = 1;
+    int off = 0;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on));
+    // take IPv4 connections on the same socket
+    setsockopt(listener, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof (off));
+    sockaddr_in6 address;
+    std::memset(&address, 0, sizeof (address));
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(port);
+    if (bind(listener, reinterpret_cast<sockaddr*> (&address), sizeof (address)) != 0
+            || listen(listener, 64) != 0) {
+        close(listener);
+        throw "Could not listen for the coordinator";
+    }
+    while (true) {
+        const int fd = accept(listener, nullptr, nullptr);
+        if (fd == -1)
+            continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof (on));
+        // the connection's thread owns it, handle is only copied in
+        std::thread([fd, handle, onClose]() {
+            std::string buffer;
+            std::string line;
+            std::string state;
+            while (readLine(fd, buffer, line)) {
+                // anything escaping the thread would end the whole worker,
+                // the coordinator is told instead
+                std::string reply;
+                try {
+                    reply = handle(line, state);
+                } catch (const char* error) {
+                    reply = std::string("ERR ") + error;
+                } catch (const std::exception& error) {
+                    reply = std::string("ERR ") + error.what();
+                } catch (...) {
+                    reply = "ERR Could not handle the request";
+                }
+                if (!sendLine(fd, reply))
+                    break;
+            }
+            close(fd);
+            onClose(state);
+        }).detach();
+    }
+}
+
+#endif /* REMOTE_WORKERS_CPP */
@@ -0,0 +1,79 @@
+/*
+ * File:   RemoteWorkers.h
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#ifndef REMOTE_WORKERS_H
+#define REMOTE_WORKERS_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include "FitnessCache.h"
+
+// Connections from the GA (the coordinator) to worker processes on other
+// machines that simulate and classify Rulesets for it, so the Fitness of a
+// Population can be calculated on a whole cluster. The protocol is one line
+// of text per message over TCP:
+//   PARAMS <params>                 ->  OK | ERR <reason>
+//   EVAL <gen> <soup> <chromosome>  ->  <alive> <percent> <active> <class>
+//                                       | ERR <reason>
+// PARAMS is sent once per connection and has to come first, it holds the
+// simulation parameters every EVAL on the connection is simulated with.
+// Each connection runs one EVAL at a time, so a worker that should work on
+// several Rulesets at once is connected to several times.
+// Safe to use from several threads at once
+class RemoteWorkers {
+public:
+    // constructor
+    // connects to every "host:port" of addresses and sends them params,
+    // throws if any of them can't be reached or won't take the params
+    RemoteWorkers(const std::vector<std::string>& addresses,
+            const std::string& params);
+
+    // closes every connection
+    ~RemoteWorkers();
+
+    // has one of the workers simulate and classify a chromosome on the
+    // given soup, waiting for a connection to be free. A connection that
+    // fails is dropped and the chromosome tried on another, this only
+    // throws once none are left or a worker says the chromosome failed
+    RuleMetrics evaluate(const std::string& chromosome, const int gen,
+            const int soup);
+
+    // returns the number of connections still open
+    int size();
+
+    // listens on port and answers every line each connection sends with
+    // handle(line, connection's state), one thread per connection. state
+    // starts out "" for every connection and is for the handler to keep
+    // track of it with (the PARAMS it was sent), onClose is called with it
+    // once the connection is gone. Anything handle throws is answered with
+    // "ERR " and the error. Never returns unless it can't listen
+    static void serve(const int port,
+            const std::function<std::string(const std::string&, std::string&)>& handle,
+            const std::function<void(const std::string&)>& onClose);
+
+private:
+    struct Connection {
+        std::string address;
+        int fd;
+        std::string buffer; // bytes received after the last full line
+    };
+    std::vector<Connection> connections;
+    std::vector<size_t> idle; // connections no EVAL is running on
+    int openCount;
+    std::mutex lock;
+    std::condition_variable idleReady; // signalled when idle grows or shrinks
+
+    // sends line and a '\n', false if the connection is gone
+    static bool sendLine(const int fd, const std::string& line);
+
+    // reads up to the next '\n' into line, false if the connection is gone
+    static bool readLine(const int fd, std::string& buffer, std::string& line);
+};
+
+#endif /* REMOTE_WORKERS_H */
@@ -0,0 +1,178 @@
+#ifndef RLE_READER_CPP
+#define RLE_READER_CPP
+
+/*
+ * File:   RleReader.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <string>
+#include <algorithm>
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "RleReader.h"
+#include "BitKernels.h"
+
+static const int posQualifierLen = 4; // "Pos=" length in rle header
+
+RleReader::RleReader(const std::string& path) {
+    this->text = nullptr;
+    this->length = 0;
+    this->mapped = false;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw "Could not open rle file";
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            this->text = static_cast<const char*> (map);
+            this->length = info.st_size;
+            this->mapped = true;
+        }
+    }
+    // the mapping stays valid without the file descriptor
+    close(fd);
+    if (!this->mapped)
+        throw "Could not map rle file";
+    madvise(const_cast<char*> (this->text), this->length, MADV_SEQUENTIAL);
+    this->parseHeaders();
+}
+
+RleReader::RleReader(const char* text, const size_t length) {
+    this->text = text;
+    this->length = length;
+    this->mapped = false;
+    this->parseHeaders();
+}
+
+RleReader::~RleReader() {
+    if (this->mapped)
+        munmap(const_cast<char*> (this->text), this->length);
+}
+
+int RleReader::getX() const {
+    return this->x;
+}
+
+int RleReader::getY() const {
+    return this->y;
+}
+
+int RleReader::getWidth() const {
+    return this->width;
+}
+
+int RleReader::getHeight() const {
+    return this->height;
+}
+
+size_t RleReader::getLength() const {
+    return this->length;
+}
+
+const char* RleReader::bodyBegin() const {
+    return this->body;
+}
+
+const char* RleReader::bodyEnd() const {
+    return this->text + this->length;
+}
+
+void RleReader::parseHeaders() {
+    const char* end = this->text + this->length;
+    const char* firstEnd = std::find(this->text, end, '\n');
+    if (firstEnd == end)
+        throw "Invalid rle header";
+    const char* secEnd = std::find(firstEnd + 1, end, '\n');
+    parsePos(this->text, firstEnd, this->x, this->y);
+    parseSize(firstEnd + 1, secEnd, this->width, this->height);
+    this->body = secEnd == end ? end : secEnd + 1;
+}
+
+void RleReader::parsePos(const char* begin, const char* end, int& x,
+        int& y) {
+    // the position is the second word, after its "Pos=" qualifier
+    const char* pos = std::find(begin, end, ' ');
+    while (pos != end && *pos == ' ') {
+        pos++;
+    }
+    pos += posQualifierLen;
+    if (pos >= end)
+        throw "Invalid rle position header";
+    auto result = std::from_chars(pos, end, x);
+    if (result.ec != std::errc() || result.ptr == end || *result.ptr != ',')
+        throw "Invalid rle position header";
+    result = std::from_chars(result.ptr + 1, end, y);
+    if (result.ec != std::errc())
+        throw "Invalid rle position header";
+}
+
+void RleReader::parseSize(const char* begin, const char* end, int& width,
+        int& height) {
+    // "x = width, y = height, rule = ..." so the numbers follow the first
+    // two '='
+    int* values[2] = {&width, &height};
+    const char* pos = begin;
+    for (int i = 0; i < 2; i++) {
+        pos = std::find(pos, end, '=');
+        if (pos == end)
+            throw "Invalid rle size header";
+        pos++;
+        while (pos != end && *pos == ' ') {
+            pos++;
+        }
+        auto result = std::from_chars(pos, end, *values[i]);
+        if (result.ec != std::errc())
+            throw "Invalid rle size header";
+        pos = result.ptr;
+    }
+}
+
+void RleReader::decodeFrame(GenerationFrame& frame) const {
+    frame.resize(this->x, this->y, this->width, this->height);
+    this->decodeInto(frame.bits.data(), frame.wordsPerRow, this->x, this->y,
+            this->width, this->height);
+}
+
+void RleReader::decodeInto(uint64_t* genWords, const int wordsPerRow,
+        const int genX, const int genY, const int genWidth,
+        const int rowCount) const {
+    long long int relX = this->x - genX;
+    long long int relY = this->y - genY;
+    const long long int startX = relX;
+    const char* pos = this->body;
+    const char* end = this->bodyEnd();
+    while (pos != end) {
+        char c = *pos;
+        long long int repCount = 1;
+        if (c >= '0' && c <= '9') {
+            auto result = std::from_chars(pos, end, repCount);
+            pos = result.ptr;
+            if (pos == end)
+                break;
+            c = *pos;
+        }
+        pos++;
+        if (c == 'o') { // run of live cells
+            if (relX < 0 || relY < 0 || relX + repCount > genWidth
+                    || relY >= rowCount)
+                throw "Invalid coordinates outside of the board";
+            bitkernels::setBitRange(genWords + relY * wordsPerRow, relX,
+                    repCount);
+            relX += repCount;
+        } else if (c == 'b') { // dead cells are already 0
+            relX += repCount;
+        } else if (c == '$') { // new rows
+            relX = startX;
+            relY += repCount;
+        } else if (c == '!') // end of pattern
+            break;
+    }
+}
+
+#endif /* RLE_READER_CPP */
@@ -0,0 +1,80 @@
+/*
+ * File:   RleReader.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef RLE_READER_H
+#define RLE_READER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "GenerationFrame.h"
+
+// Decoder for the .rle files golly-script.py saves. The text is either
+// memory mapped straight from the file (the file descriptor is closed as
+// soon as the mapping exists) or read from a buffer owned by the caller.
+// The headers are parsed with std::from_chars as soon as the reader is made
+// and the body is decoded a run at a time, setting whole runs of live cells
+// with one bit range write instead of one cell at a time.
+class RleReader {
+public:
+    // maps the file at path, throws if it can't be opened
+    explicit RleReader(const std::string& path);
+
+    // reads length chars of text, which have to outlive the reader
+    RleReader(const char* text, const size_t length);
+
+    // unmaps the file if there is one
+    ~RleReader();
+
+    RleReader(const RleReader&) = delete;
+    RleReader& operator=(const RleReader&) = delete;
+
+    // position of the top left corner and size of the pattern from headers
+    int getX() const;
+    int getY() const;
+    int getWidth() const;
+    int getHeight() const;
+
+    // returns the number of chars of text
+    size_t getLength() const;
+
+    // returns the encoded pattern that follows the two header lines
+    const char* bodyBegin() const;
+    const char* bodyEnd() const;
+
+    // sets the live cells of the pattern in a bit-packed generation whose
+    // top left corner is at (genX, genY), genWords having wordsPerRow words
+    // for each of rowCount rows. Throws if the pattern doesn't fit
+    void decodeInto(uint64_t* genWords, const int wordsPerRow,
+            const int genX, const int genY, const int genWidth,
+            const int rowCount) const;
+
+    // resizes the frame to the box given by the headers and decodes the
+    // pattern into it
+    void decodeFrame(GenerationFrame& frame) const;
+
+    // parses "#CXRLE Pos=x,y ..." (the first header line)
+    static void parsePos(const char* begin, const char* end, int& x, int& y);
+
+    // parses "x = width, y = height, ..." (the second header line)
+    static void parseSize(const char* begin, const char* end, int& width,
+            int& height);
+
+private:
+    const char* text;
+    size_t length;
+    bool mapped; // true if text has to be unmapped
+    const char* body; // first char after the headers
+    int x;
+    int y;
+    int width;
+    int height;
+
+    // finds the header lines and parses them
+    void parseHeaders();
+};
+
+#endif /* RLE_READER_H */
@@ -0,0 +1,159 @@
+/*
+ * File:   RuleKernels.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef RULE_KERNELS_H
+#define RULE_KERNELS_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Kernels that turn the neighbour counts of a word of 64 cells into the
+// cells' next state. The counts come as 4 bit planes (bit b of the count of
+// cell i is bit i of planes[b]). FixedRule has the rule as template
+// arguments so its loop over the counts is unrolled and only the counts the
+// rule mentions are tested, TableRule works for any rule at run time.
+// Both are handed to a stepper as a template argument, so the stepper's
+// loops are compiled once per kernel with the rule inlined into them.
+
+namespace rulekernels {
+
+// bit n of the result is set if the part of rule after the letter (b or s)
+// names n neighbours, rule being written the way decode() writes it
+constexpr uint16_t countMask(const char* rule, const char letter) {
+    uint16_t mask = 0;
+    bool inPart = false;
+    for (const char* c = rule; *c != '\0'; c++) {
+        if (*c == 'b' || *c == 's')
+            inPart = *c == letter;
+        else if (inPart && *c >= '0' && *c <= '8')
+            mask |= 1 << (*c - '0');
+    }
+    return mask;
+}
+
+// adds the 8 neighbour bits of every cell up into 4 bit planes with
+// bit-sliced full adders
+inline void countNeighbours(const uint64_t n[8], uint64_t planes[4]) {
+    uint64_t t0 = n[0] ^ n[1];
+    uint64_t s0 = t0 ^ n[2];
+    uint64_t c0 = (n[0] & n[1]) | (t0 & n[2]);
+    uint64_t t1 = n[3] ^ n[4];
+    uint64_t s1 = t1 ^ n[5];
+    uint64_t c1 = (n[3] & n[4]) | (t1 & n[5]);
+    uint64_t s2 = n[6] ^ n[7];
+    uint64_t c2 = n[6] & n[7];
+    uint64_t t3 = s0 ^ s1;
+    planes[0] = t3 ^ s2;
+    uint64_t c3 = (s0 & s1) | (t3 & s2);
+    // c0, c1, c2 and c3 all have weight 2
+    uint64_t t4 = c0 ^ c1;
+    uint64_t s4 = t4 ^ c2;
+    uint64_t c4 = (c0 & c1) | (t4 & c2);
+    planes[1] = s4 ^ c3;
+    uint64_t c5 = s4 & c3;
+    planes[2] = c4 ^ c5;
+    planes[3] = c4 & c5;
+}
+
+// bits of the cells that have count neighbours
+inline uint64_t countIs(const uint64_t planes[4], const int count) {
+    uint64_t match = ~uint64_t(0);
+    for (int b = 0; b < 4; b++) {
+        match &= (count >> b) & 1 ? planes[b] : ~planes[b];
+    }
+    return match;
+}
+
+// a rule known at compile time, Birth and Survive being its masks (bit n
+// set if n neighbours cause a birth/survival)
+template <uint16_t Birth, uint16_t Survive>
+struct FixedRule {
+    uint64_t operator()(const uint64_t planes[4], const uint64_t self) const {
+        return this->from<0>(planes, self);
+    }
+
+private:
+    // the cells that are alive next with Count or more neighbours
+    template <int Count>
+    uint64_t from(const uint64_t planes[4], const uint64_t self) const {
+        if constexpr (Count > 8) {
+            return 0;
+        } else {
+            uint64_t next = this->from<Count + 1>(planes, self);
+            constexpr bool born = (Birth >> Count) & 1;
+            constexpr bool survives = (Survive >> Count) & 1;
+            if constexpr (born && survives)
+                next |= countIs(planes, Count);
+            else if constexpr (born)
+                next |= countIs(planes, Count) & ~self;
+            else if constexpr (survives)
+                next |= countIs(planes, Count) & self;
+            return next;
+        }
+    }
+};
+
+// any rule, looked up in a table of what each neighbour count does to a
+// dead and to a live cell so there is no branch on the rule per word
+struct TableRule {
+    TableRule(const uint16_t birth, const uint16_t survive) {
+        this->countNum = 0;
+        for (int n = 0; n <= 8; n++) {
+            if (!((birth | survive) & (1 << n)))
+                continue;
+            this->counts[this->countNum] = n;
+            this->born[this->countNum] = birth & (1 << n) ? ~uint64_t(0) : 0;
+            this->flip[this->countNum] = this->born[this->countNum]
+                    ^ (survive & (1 << n) ? ~uint64_t(0) : 0);
+            this->countNum++;
+        }
+    }
+
+    uint64_t operator()(const uint64_t planes[4], const uint64_t self) const {
+        uint64_t next = 0;
+        for (int i = 0; i < this->countNum; i++) {
+            next |= countIs(planes, this->counts[i])
+                    & (this->born[i] ^ (self & this->flip[i]));
+        }
+        return next;
+    }
+
+private:
+    // only the counts the rule mentions, with all ones in born where they
+    // cause a birth and in flip where a live cell does the opposite
+    int countNum;
+    int counts[9];
+    uint64_t born[9];
+    uint64_t flip[9];
+};
+
+// Rules given their own FixedRule, the ones re-run the most: the known
+// rules used as baselines (Life, HighLife, the Replicator, Day & Night,
+// Seeds and Maze). Adding one here is all it takes, at the cost of
+// another copy of the stepper's loops
+constexpr const char* hotRules[] = {"b3/s23", "b36/s23", "b1357/s1357",
+    "b3678/s34678", "b2/s", "b3/s12345"};
+constexpr size_t hotRuleNum = sizeof (hotRules) / sizeof (hotRules[0]);
+
+// calls step with the FixedRule of the rule birth/survive if it is one of
+// hotRules and with its TableRule otherwise
+template <size_t I = 0, typename Step>
+void dispatch(const uint16_t birth, const uint16_t survive, Step&& step) {
+    if constexpr (I == hotRuleNum) {
+        step(TableRule(birth, survive));
+    } else {
+        constexpr uint16_t hotBirth = countMask(hotRules[I], 'b');
+        constexpr uint16_t hotSurvive = countMask(hotRules[I], 's');
+        if (birth == hotBirth && survive == hotSurvive)
+            step(FixedRule<hotBirth, hotSurvive>());
+        else
+            dispatch<I + 1>(birth, survive, step);
+    }
+}
+
+} // namespace rulekernels
+
+#endif /* RULE_KERNELS_H */
@@ -0,0 +1,149 @@
+#ifndef RULE_ORACLE_CPP
+#define RULE_ORACLE_CPP
+
+/*
+ * File:   RuleOracle.cpp
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include "RuleOracle.h"
+
+// every oracle file starts with these bytes
+static const char ORACLE_MAGIC[8] = {'C', 'A', 'G', 'A', 'O', 'R', '0', '1'};
+
+// bytes of a record: 3 doubles of metrics and a uint8 classNum
+static const size_t RECORD_BYTES = 3 * sizeof (double) + 1;
+
+RuleOracle::RuleOracle(const std::string& paramsKey,
+        const std::string& fileName, const int soupCount) {
+    this->paramsKey = paramsKey;
+    this->fileName = fileName;
+    this->soupCount = soupCount;
+    if (!this->load()) {
+        if (soupCount == 0)
+            throw "Oracle file does not exist";
+        this->records.assign((size_t) soupCount * ruleCount, RuleMetrics{0, 0, 0, 0});
+    }
+}
+
+bool RuleOracle::lookup(const uint32_t packed, RuleMetrics& metrics,
+        const int soup) const {
+    if (soup >= this->soupCount || packed >= ruleCount)
+        return false;
+    const RuleMetrics& record = this->records[(size_t) soup * ruleCount + packed];
+    if (record.classNum == 0)
+        return false;
+    metrics = record;
+    return true;
+}
+
+void RuleOracle::store(const uint32_t packed, const RuleMetrics& metrics,
+        const int soup) {
+    if (soup >= this->soupCount || packed >= ruleCount)
+        throw "Chromosome or soup is outside of the oracle";
+    this->records[(size_t) soup * ruleCount + packed] = metrics;
+}
+
+int RuleOracle::getSoupCount() const {
+    return this->soupCount;
+}
+
+long long int RuleOracle::size(const int soup) const {
+    if (soup >= this->soupCount)
+        return 0;
+    auto first = this->records.begin() + (size_t) soup * ruleCount;
+    return std::count_if(first, first + ruleCount, [](const RuleMetrics& r) {
+        return r.classNum != 0;
+    });
+}
+
+// the file is the magic, uint32 key length, key, uint32 soup count, then
+// for every soup a record for every packed chromosome in order, each one
+// being 3 doubles of metrics and a uint8 classNum
+bool RuleOracle::load() {
+    std::ifstream in(this->fileName, std::ios::binary);
+    if (!in.is_open())
+        return false; // nothing swept yet
+    char magic[sizeof (ORACLE_MAGIC)];
+    if (!in.read(magic, sizeof (magic))
+            || !std::equal(magic, magic + sizeof (magic), ORACLE_MAGIC))
+        throw "Oracle file is not an oracle file";
+    uint32_t keyLen;
+    uint32_t fileSoupCount;
+    std::string key;
+    if (in.read(reinterpret_cast<char*> (&keyLen), sizeof (keyLen))) {
+        key.assign(keyLen, '\0');
+        in.read(&key[0], keyLen);
+    }
+    if (!in.read(reinterpret_cast<char*> (&fileSoupCount), sizeof (fileSoupCount)))
+        throw "Oracle file is truncated";
+    if (key != this->paramsKey)
+        throw "Oracle file was swept with other parameters";
+    if (this->soupCount != 0 && (int) fileSoupCount != this->soupCount)
+        throw "Oracle file was swept on another number of soups";
+    this->soupCount = fileSoupCount;
+    // read a soup at a time instead of a record at a time
+    this->records.resize((size_t) this->soupCount * ruleCount);
+    std::vector<char> bytes(ruleCount * RECORD_BYTES);
+    for (int soup = 0; soup < this->soupCount; soup++) {
+        if (!in.read(bytes.data(), bytes.size()))
+            throw "Oracle file is truncated";
+        RuleMetrics* soupRecords = this->records.data() + (size_t) soup * ruleCount;
+        for (uint32_t i = 0; i < ruleCount; i++) {
+            const char* record = bytes.data() + i * RECORD_BYTES;
+            std::copy(record, record + sizeof (double),
+                    reinterpret_cast<char*> (&soupRecords[i].aliveCell));
+            std::copy(record + sizeof (double), record + 2 * sizeof (double),
+                    reinterpret_cast<char*> (&soupRecords[i].percentChange));
+            std::copy(record + 2 * sizeof (double), record + 3 * sizeof (double),
+                    reinterpret_cast<char*> (&soupRecords[i].activeCell));
+            soupRecords[i].classNum = (unsigned char) record[3 * sizeof (double)];
+        }
+    }
+    return true;
+}
+
+void RuleOracle::save() const {
+    // write next to the real file and rename it over, which is atomic
+    std::string tempName = this->fileName + ".tmp";
+    {
+        std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            throw "Could not write the oracle file";
+        out.write(ORACLE_MAGIC, sizeof (ORACLE_MAGIC));
+        uint32_t keyLen = this->paramsKey.length();
+        uint32_t fileSoupCount = this->soupCount;
+        out.write(reinterpret_cast<const char*> (&keyLen), sizeof (keyLen));
+        out.write(this->paramsKey.data(), keyLen);
+        out.write(reinterpret_cast<const char*> (&fileSoupCount),
+                sizeof (fileSoupCount));
+        std::vector<char> bytes(ruleCount * RECORD_BYTES);
+        for (int soup = 0; soup < this->soupCount; soup++) {
+            const RuleMetrics* soupRecords = this->records.data()
+                    + (size_t) soup * ruleCount;
+            for (uint32_t i = 0; i < ruleCount; i++) {
+                char* record = bytes.data() + i * RECORD_BYTES;
+                const char* alive = reinterpret_cast<const char*> (&soupRecords[i].aliveCell);
+                const char* percent = reinterpret_cast<const char*> (&soupRecords[i].percentChange);
+                const char* active = reinterpret_cast<const char*> (&soupRecords[i].activeCell);
+                std::copy(alive, alive + sizeof (double), record);
+                std::copy(percent, percent + sizeof (double), record + sizeof (double));
+                std::copy(active, active + sizeof (double), record + 2 * sizeof (double));
+                record[3 * sizeof (double)] = (char) soupRecords[i].classNum;
+            }
+            out.write(bytes.data(), bytes.size());
+        }
+        if (!out)
+            throw "Could not write the oracle file";
+    }
+    if (std::rename(tempName.c_str(), this->fileName.c_str()) != 0)
+        throw "Could not replace the oracle file";
+}
+
+#endif /* RULE_ORACLE_CPP */
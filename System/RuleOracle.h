@@ -0,0 +1,70 @@
+/*
+ * File:   RuleOracle.h
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#ifndef RULE_ORACLE_H
+#define RULE_ORACLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FitnessCache.h"
+
+// The RuleMetrics of every one of the 2^18 Rulesets (or a band of them) on
+// each of a run's soups, found once by a sweep and then looked up by GA
+// runs instead of simulating. Unlike the FitnessCache the file is indexed:
+// it holds a fixed size record for every chromosome of every soup, so a
+// lookup is an array index and the file is the same size however much of it
+// has been swept. Rulesets not swept yet have classNum 0.
+// paramsKey describes the simulation parameters the metrics were found
+// with, the same way it does for the FitnessCache.
+// lookup can be used from several threads at once, and so can store for
+// different chromosomes, but not while the oracle is being saved
+class RuleOracle {
+public:
+    // number of chromosomes, one for every set of birth and survival
+    // conditions
+    static const uint32_t ruleCount = uint32_t(1) << 18;
+
+    // constructor
+    // loads fileName if it exists, otherwise starts out with nothing swept
+    // on soupCount soups. Throws if the file was swept with other
+    // parameters or another number of soups. soupCount 0 takes the file's
+    // and throws if there is no file
+    RuleOracle(const std::string& paramsKey, const std::string& fileName,
+            const int soupCount);
+
+    // true if the chromosome has been swept on the given soup, copying its
+    // metrics to metrics if so
+    bool lookup(const uint32_t packed, RuleMetrics& metrics,
+            const int soup = 0) const;
+
+    // sets the metrics of a chromosome on the given soup
+    void store(const uint32_t packed, const RuleMetrics& metrics,
+            const int soup = 0);
+
+    // writes every record to the file. The file is replaced in one go so a
+    // crash never leaves a half written oracle behind
+    void save() const;
+
+    // returns number of soups the oracle has records for
+    int getSoupCount() const;
+
+    // returns number of chromosomes swept on the given soup
+    long long int size(const int soup = 0) const;
+
+private:
+    std::string paramsKey;
+    std::string fileName;
+    int soupCount;
+    // record soup * ruleCount + packed chromosome
+    std::vector<RuleMetrics> records;
+
+    // reads every record in the file, returns false if there is no such
+    // file and throws if it isn't an oracle file
+    bool load();
+};
+
+#endif /* RULE_ORACLE_H */
@@ -0,0 +1,170 @@
+#ifndef SIMULATION_ENGINE_CPP
+#define SIMULATION_ENGINE_CPP
+
+/*
+ * File:   SimulationEngine.cpp
+ * Author: Eric Schonauer
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "SimulationEngine.h"
+
+SimulationEngine::SimulationEngine(const std::string& chromosome) {
+    const RuleMasks masks = getRuleMasks(chromosome);
+    this->evenBirth = masks.evenBirth;
+    this->evenSurvive = masks.evenSurvive;
+    this->oddBirth = masks.oddBirth;
+    this->oddSurvive = masks.oddSurvive;
+    this->generation = 0;
+    this->settledClass = 0;
+}
+
+SimulationEngine::~SimulationEngine() {
+}
+
+SimulationEngine::RuleMasks SimulationEngine::getRuleMasks(
+        const std::string& chromosome) {
+    uint16_t birth = 0;
+    uint16_t survive = 0;
+    for (int i = 0; i < 9; i++) {
+        if (chromosome[i] == '1')
+            birth |= 1 << i;
+        if (chromosome[i + 9] == '1')
+            survive |= 1 << i;
+    }
+    auto mirror = [](const uint16_t mask) {
+        // bit n of the result is bit 8 - n of mask
+        uint16_t mirrored = 0;
+        for (int n = 0; n <= 8; n++) {
+            if (mask & (1 << (8 - n)))
+                mirrored |= 1 << n;
+        }
+        return mirrored;
+    };
+    const uint16_t allCounts = 0x1FF;
+    RuleMasks masks;
+    if (!(birth & 1)) { // no emulation necessary
+        masks.evenBirth = masks.oddBirth = birth;
+        masks.evenSurvive = masks.oddSurvive = survive;
+    } else if (survive & (1 << 8)) {
+        // B0 and S8: simulate the inverse universe using the B counts
+        // not in S(8-n) and the S counts not in B(8-n)
+        masks.evenBirth = masks.oddBirth = ~mirror(survive) & allCounts;
+        masks.evenSurvive = masks.oddSurvive = ~mirror(birth) & allCounts;
+    } else {
+        // B0 without S8: even generations step into an inverted odd
+        // generation and odd generations step back into a real even one
+        masks.evenBirth = ~birth & allCounts;
+        masks.evenSurvive = ~survive & allCounts;
+        masks.oddBirth = mirror(survive);
+        masks.oddSurvive = mirror(birth);
+    }
+    return masks;
+}
+
+bool SimulationEngine::alternating() const {
+    return this->evenBirth != this->oddBirth
+            || this->evenSurvive != this->oddSurvive;
+}
+
+void SimulationEngine::fillSoup(const int gridSize, const int fillPercent,
+        const unsigned int seed,
+        const std::function<void(const int, const int)>& setCell) {
+    std::mt19937 rng(seed);
+    for (int y = 0; y < gridSize; y++) {
+        for (int x = 0; x < gridSize; x++) {
+            if (static_cast<int> (rng() % 100) < fillPercent)
+                setCell(x, y);
+        }
+    }
+}
+
+int SimulationEngine::advanceUnlessSettled(const int targetGen) {
+    const int startGen = this->generation;
+    GenerationFrame previous;
+    while (true) {
+        if (this->empty())
+            return this->generation;
+        GenerationFrame frame = this->getFrame();
+        // same check as compare_rle in golly-script.py
+        if (this->generation > startGen && frame.sameShape(previous))
+            return this->generation;
+        if (this->generation >= targetGen)
+            return -1;
+        previous = std::move(frame);
+        this->step();
+    }
+}
+
+std::vector<GenerationFrame> SimulationEngine::run(const int genNum) {
+    std::vector<GenerationFrame> frames;
+    this->run(genNum, [&](const GenerationFrame& frame) {
+        frames.push_back(frame);
+    });
+    return frames;
+}
+
+void SimulationEngine::run(const int genNum,
+        const std::function<void(const GenerationFrame&)>& onFrame,
+        const bool stopWhenSettled, const int firstFrameGen) {
+    // once a shape comes back the pattern is the same as it was back then,
+    // just moved, so it keeps cycling through the same shapes and never dies
+    // or stops changing. With two alternating rules that is only true if the
+    // two generations were simulated with the same rule, so the parity has
+    // to match too
+    const bool alternating = this->alternating();
+    ShapeHistory seenShapes;
+    GenerationFrame previous;
+    this->settledClass = 0;
+    int i = 0;
+    const int skippedGens = std::min(firstFrameGen, genNum);
+    if (skippedGens > 0) {
+        // the generation before the first one handed over is still needed
+        // to compare that one with
+        if (this->advanceUnlessSettled(skippedGens - 1) != -1) {
+            this->settledClass = 1;
+            return;
+        }
+        previous = this->getFrame();
+        this->step();
+        i = skippedGens;
+    }
+    for (; i <= genNum; i++) {
+        // stop if universe is empty
+        if (this->empty()) {
+            this->settledClass = 1;
+            break;
+        }
+        GenerationFrame frame = this->getFrame();
+        onFrame(frame);
+        // same check as compare_rle in golly-script.py
+        if (i > 0 && frame.sameShape(previous)) {
+            if (i < genNum)
+                this->settledClass = 1;
+            break;
+        }
+        if (stopWhenSettled && i < genNum) {
+            const int parity = alternating ? this->generation % 2 : 0;
+            if (seenShapes.addUnlessSeen(frame, parity)) {
+                this->settledClass = 2;
+                break;
+            }
+        }
+        previous = std::move(frame);
+        this->step();
+    }
+}
+
+int SimulationEngine::getSettledClass() const {
+    return this->settledClass;
+}
+
+int SimulationEngine::getGeneration() const {
+    return this->generation;
+}
+
+#endif /* SIMULATION_ENGINE_CPP */
@@ -0,0 +1,116 @@
+/*
+ * File:   SimulationEngine.h
+ * Author: Eric Schonauer
+ *
+ */
+
+#ifndef SIMULATION_ENGINE_H
+#define SIMULATION_ENGINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include "GenerationFrame.h"
+
+// Interface of the in-process simulators for Life-like (B/S) rules on an
+// unbounded plane, meant to stand in for the golly QuickLife run done by
+// golly-script.py. The engines only differ in how they store and advance
+// the pattern, the rule emulation golly does for B0 rules, the random soup
+// and the loop golly-script.py runs are shared so every engine hands over
+// the same generations for the same chromosome and seed.
+class SimulationEngine {
+public:
+    // constructor
+    // takes the 18 char chromosome used by the GA (first 9 genes are the birth
+    // conditions 0-8, last 9 genes are the survival conditions 0-8)
+    explicit SimulationEngine(const std::string& chromosome);
+
+    virtual ~SimulationEngine();
+
+    // advances the pattern by one generation
+    virtual void step() = 0;
+
+    // true if there are no live cells left
+    virtual bool empty() const = 0;
+
+    // returns the current generation cropped to the live cells
+    virtual GenerationFrame getFrame() const = 0;
+
+    // runs the same loop golly-script.py does and returns every generation
+    // it would have saved: stops early if the universe becomes empty (that
+    // generation is not returned) or if a generation has the same pattern as
+    // the one before it (that generation is still returned). At most
+    // genNum + 1 generations are returned, generation 0 being the soup
+    std::vector<GenerationFrame> run(const int genNum);
+
+    // same as above but hands every generation to onFrame as soon as it is
+    // simulated instead of keeping them all. With stopWhenSettled the run
+    // also stops as soon as a pattern repeats in a way that makes every
+    // later generation a repeat too, see getSettledClass.
+    // Generations before firstFrameGen are not handed over, which lets the
+    // engine get past them any way it likes (see advanceUnlessSettled), and
+    // only the generations handed over are checked for repeats
+    void run(const int genNum,
+            const std::function<void(const GenerationFrame&)>& onFrame,
+            const bool stopWhenSettled = false, const int firstFrameGen = 0);
+
+    // after a run, returns the class the run settled into: 1 if fewer than
+    // genNum + 1 generations were simulated because the universe died out
+    // or stopped changing, 2 if it was
+    // stopped by stopWhenSettled because the pattern repeats forever, 0 if
+    // it ran all genNum generations without either. Repeats are looked up
+    // by the hash of every generation's shape and only count once the two
+    // shapes compare equal, see ShapeHistory
+    int getSettledClass() const;
+
+    // returns number of the current generation, 0 being the soup
+    int getGeneration() const;
+
+    // birth and survival masks a rule is simulated with, see evenBirth
+    struct RuleMasks {
+        uint16_t evenBirth;
+        uint16_t evenSurvive;
+        uint16_t oddBirth;
+        uint16_t oddSurvive;
+    };
+
+    // works out the even and odd rules of an 18 char chromosome
+    static RuleMasks getRuleMasks(const std::string& chromosome);
+
+    // goes through the gridSize x gridSize square at the origin row by row
+    // and calls setCell for the cells of the random soup, each cell being
+    // alive with a chance of fillPercent percent like g.randfill does. The
+    // same seed always gives the same soup
+    static void fillSoup(const int gridSize, const int fillPercent,
+            const unsigned int seed,
+            const std::function<void(const int, const int)>& setCell);
+
+protected:
+    // rules containing B0 are emulated the way golly does it, which means
+    // the pattern that gets displayed is not always the real one:
+    // B0 with S8 - the inverse universe is simulated with an equivalent rule
+    // B0 without S8 - two rules are used alternating between even and odd
+    // generations and the odd generations are shown inverted.
+    // bit n of a mask is set if n neighbours cause a birth/survival
+    uint16_t evenBirth;
+    uint16_t evenSurvive;
+    uint16_t oddBirth;
+    uint16_t oddSurvive;
+    int generation;
+    int settledClass;
+
+    // true if even and odd generations are stepped with different rules
+    bool alternating() const;
+
+    // advances the pattern from the current generation to targetGen, unless
+    // golly-script.py would have stopped before getting there, which is
+    // at the first generation that is empty or has the same pattern as the
+    // one before it. Returns that generation (the pattern is left there) or
+    // -1 if targetGen was reached without stopping. This default steps one
+    // generation at a time and compares every frame with the one before it
+    virtual int advanceUnlessSettled(const int targetGen);
+
+};
+
+#endif /* SIMULATION_ENGINE_H */
@@ -0,0 +1,89 @@
+#ifndef THREAD_POOL_CPP
+#define THREAD_POOL_CPP
+
+/*
+ * File:   ThreadPool.cpp
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(const int threadNum) {
+    this->pending = 0;
+    this->stopping = false;
+    int count = threadNum;
+    if (count <= 0)
+        count = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < count; i++) {
+        this->workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->allDone.wait(guard, [this] { return this->pending == 0; });
+        this->stopping = true;
+    }
+    this->taskReady.notify_all();
+    for (auto& worker : this->workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->tasks.push(std::move(task));
+        this->pending++;
+    }
+    this->taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->allDone.wait(guard, [this] { return this->pending == 0; });
+    if (this->firstError) {
+        std::exception_ptr error = this->firstError;
+        this->firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+int ThreadPool::size() const {
+    return (int) this->workers.size();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+            this->taskReady.wait(guard, [this] {
+                return this->stopping || !this->tasks.empty();
+            });
+            if (this->tasks.empty())
+                return; // stopping and nothing left to run
+            task = std::move(this->tasks.front());
+            this->tasks.pop();
+        }
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (error && !this->firstError)
+            this->firstError = error;
+        if (--this->pending == 0)
+            this->allDone.notify_all();
+    }
+}
+
+#endif /* THREAD_POOL_CPP */
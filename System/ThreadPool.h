@@ -0,0 +1,55 @@
+/*
+ * File:   ThreadPool.h
+ * Author: Owen Hichens, Carter Hale
+ *
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+// Fixed set of worker threads that run tasks in the order they are
+// submitted. Used to evaluate the fitness of several Individuals at once.
+// The workers are started by the constructor and stay around until the
+// pool is destroyed, so they can be reused every GA generation
+class ThreadPool {
+public:
+    // constructor
+    // starts threadNum worker threads, 0 uses one per hardware thread
+    ThreadPool(const int threadNum);
+
+    // waits for every task submitted so far and then stops the workers
+    ~ThreadPool();
+
+    // queues a task to be run by one of the workers
+    void submit(std::function<void()> task);
+
+    // blocks until every task submitted so far has finished. If any of them
+    // threw, the first exception thrown is rethrown here
+    void wait();
+
+    // returns the number of worker threads
+    int size() const;
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex lock;
+    std::condition_variable taskReady; // signalled when a task is queued
+    std::condition_variable allDone; // signalled when pending drops to 0
+    int pending; // tasks queued or running
+    bool stopping;
+    std::exception_ptr firstError;
+
+    // loop every worker runs, taking tasks off the queue until stopping
+    void workerLoop();
+};
+
+#endif /* THREAD_POOL_H */
@@ -10,16 +10,81 @@ import golly as g
 import os
 # Element Tree for XML Parsing
 import xml.etree.ElementTree as ET
+# Struct and Zlib to write Generation Dumps
+import struct
+import zlib
 
 
 # -----------------------------------------------------------------------------
-# Function to compare RLE Files for Homogeneity
-def compare_rle(fileName1, fileName2):
-    with open(fileName1, 'r') as file1:
-        with open(fileName2, 'r') as file2:
-            difference = set(file1).difference(file2)
+# Generation Dump Writer, the Format is described in GenerationDump.h. Every
+# Generation of a Rule Set goes into one File instead of a File each
+DUMP_MAGIC = b"CAGAGD01"
+
+
+# Function to get the Current Generation as its Bounding Box and Bit-Packed
+# Rows, 64 Cells to a Word with the lowest Bit being the leftmost Cell
+def get_frame():
+    rect = g.getrect()
+    if len(rect) == 0:
+        return (0, 0, 0, 0, [])
+    x, y, width, height = rect
+    wordsPerRow = (width + 63) // 64
+    words = [0] * (wordsPerRow * height)
+    cells = g.getcells(rect)
+    for i in range(0, len(cells) - 1, 2):
+        relX = cells[i] - x
+        index = (cells[i + 1] - y) * wordsPerRow + relX // 64
+        words[index] |= 1 << (relX % 64)
+    return (x, y, width, height, words)
+
+
+# Function to compare two Frames for Homogeneity, ignoring their Position
+def same_shape(frame1, frame2):
+    return frame1[2:] == frame2[2:]
+
+
+# Function to pad a Dump with Zeros up to the next 8 Byte Boundary
+def align_dump(dumpFile):
+    dumpFile.write(b"\0" * ((8 - dumpFile.tell() % 8) % 8))
+
+
+# Function to write a whole Generation Dump, written next to the real File
+# and renamed over it so an existing Dump is always complete
+def write_dump(fileName, ruleName, frames, compress):
+    tempName = fileName + ".tmp"
+    with open(tempName, 'wb') as dumpFile:
+        ruleBytes = ruleName.encode("ascii")
+        dumpFile.write(b"\0" * 32 + ruleBytes)
+        index = b""
+        for (x, y, width, height, words) in frames:
+            align_dump(dumpFile)
+            offset = dumpFile.tell()
+            data = struct.pack("<%dQ" % len(words), *words)
+            compressed = 0
+            if compress and len(data) > 0:
+                packed = zlib.compress(data, 1)
+                if len(packed) < len(data):
+                    data = packed
+                    compressed = 1
+            dumpFile.write(data)
+            index += struct.pack("<iiiiQII", x, y, width, height, offset,
+                                 len(data), compressed)
+        align_dump(dumpFile)
+        indexOffset = dumpFile.tell()
+        dumpFile.write(index)
+        dumpFile.seek(0)
+        dumpFile.write(DUMP_MAGIC + struct.pack("<IiQII", 0, len(frames),
+                                                indexOffset, len(ruleBytes), 0))
+    os.rename(tempName, fileName)
+# -----------------------------------------------------------------------------
+
 
-    return (len(difference) == 1)
+# -----------------------------------------------------------------------------
+# Function to write the Marker the GA waits for before it classifies a Rule
+# Set, only once every Generation of it is saved
+def mark_done(generationLoc, rule):
+    with open(generationLoc + rule.replace("/", "_") + ".done", 'w'):
+        pass
 # -----------------------------------------------------------------------------
 
 
@@ -34,12 +99,25 @@ rootGrid = rootCA.find("StartingGrid")
 # Determine Grid Properties
 gridSize = rootGrid.find("GridSize").text
 fillPerc = rootGrid.find("GridFillPerc").text
-# Determine Number of CA Generations and the CA Population
+# Determine Number of CA Generations
 timeElapsed = rootCA.find("TimeElapsed").text
-numPopulation = rootGA.find("PopulationSize").text
-
-# Check for Current GA Generation
-currentGen = rootGA.find("CurrentGeneration").text
+# Determine Number of Golly Instances the Rule Sets are split between
+gollyInstances = int(rootCA.find("GollyInstances").text)
+
+# Check for Current GA Generation and which Shard of it to Simulate. The GA
+# passes both through the Environment as Golly can't give a Script Arguments,
+# so Instances running at once never race on the XML. Ran by hand from
+# Golly, the Generation comes from the XML and is Updated there
+currentGen = os.environ.get("CAGA_GOLLY_GENERATION")
+updateXML = currentGen is None
+if updateXML:
+    currentGen = rootGA.find("CurrentGeneration").text
+shard = int(os.environ.get("CAGA_GOLLY_SHARD", "0"))
+
+# Determine whether to save a RLE File per Generation or one Dump per Rule Set
+rootFiles = root.find("FileLocations")
+useDump = rootFiles.find("GenerationFormat").text == "Dump"
+compressDump = int(rootFiles.find("CompressDumps").text) != 0
 # -----------------------------------------------------------------------------
 
 
@@ -49,23 +127,32 @@ fileLoc = g.getdir("rules") + "Simulation/"
 if (os.path.isdir(fileLoc) is not True):
     os.mkdir(fileLoc)
 
-# Creates "Generation_#" Folder within "Simulation"
+# Creates "Generation_#" Folder within "Simulation", and a "Shard_#" Folder
+# within that for each Instance when there are several
 generationDir = "Simulation/" + "Generation_" + str(currentGen) + "/"
+if gollyInstances > 1:
+    generationDir += "Shard_" + str(shard) + "/"
 fileLoc = g.getdir("rules") + generationDir
 if (os.path.isdir(fileLoc) is not True):
-    os.mkdir(fileLoc)
+    os.makedirs(fileLoc, exist_ok=True)
 # -----------------------------------------------------------------------------
 
-# Open Current Generation's Rule Sets to Parse
-rulesFileName = "rule_sets" + str(currentGen) + ".txt"
-genRules = open(rulesFileName, 'r')
+# Read Current Generation's Rule Sets, Rule Sets the GA already has Metrics
+# for are left out of the File so there may be fewer than the Population
+rulesFileName = "rule_sets" + str(currentGen)
+if gollyInstances > 1:
+    rulesFileName += "_" + str(shard)
+rulesFileName += ".txt"
+with open(rulesFileName, 'r') as genRules:
+    rules = [line.strip() for line in genRules if line.strip() != ""]
 
 # Update Current Generation
-newGen = rootGA.find("CurrentGeneration")
-newGen.text = str(int(currentGen) + 1)
-tree.write('config.xml')
+if updateXML:
+    newGen = rootGA.find("CurrentGeneration")
+    newGen.text = str(int(currentGen) + 1)
+    tree.write('config.xml')
 
-for j in range(int(numPopulation)):
+for rule in rules:
     # Create New Window and Fill X% of YxY Square Grid with Random Noise
     g.new("test-pattern")
     g.select([0, 0, int(gridSize), int(gridSize)])
@@ -74,12 +161,32 @@ for j in range(int(numPopulation)):
     # Declare Algorithm and Rule
     g.setalgo("QuickLife")
 
-    # Read In Rule Set from File
-    rule = genRules.readline().strip()
+    # Set Rule Set read from File
     g.setrule(rule)
 
     # Set Directory Back to Parent Folder
     fileLoc = g.getdir("rules") + generationDir
+    if useDump:
+        # Keep each Generation in Memory and write them all in one go
+        frames = []
+        for i in range(int(timeElapsed) + 1):
+            # Stop Loop if Universe is Empty
+            if (g.empty()):
+                break
+
+            frames.append(get_frame())
+            # Compare Previous Generation to Determine Class I Systems
+            if (i > 0 and same_shape(frames[i], frames[i-1])):
+                break
+
+            g.run(1)
+
+        ruleName = rule.replace("/", "_")
+        write_dump(fileLoc + ruleName + ".gdump", ruleName, frames,
+                   compressDump)
+        mark_done(fileLoc, rule)
+        continue
+
     # Creates Subfolder specific to Rule Set to hold Generation Patterns
     fileLoc += rule.replace("/", "_") + "/"
     if (os.path.isdir(fileLoc) is not True):
@@ -88,7 +195,9 @@ for j in range(int(numPopulation)):
     # Prepare File Names for each Genereration's Pattern File
     fileNamePrefix = fileLoc + rule.replace("/", "_") + "_"
 
-    # Loop and Save Patterns
+    # Loop and Save Patterns, only the Previous Generation is kept in Memory
+    # to Compare against instead of reading its File back
+    prevFrame = None
     for i in range(int(timeElapsed) + 1):
         # Stop Loop if Universe is Empty
         if (g.empty()):
@@ -96,15 +205,17 @@ for j in range(int(numPopulation)):
 
         # Determine File Names
         fileNameRLE = fileNamePrefix + str(i) + ".rle"
-        # Determine Previous File Names
-        fileNamePrevRLE = fileNamePrefix + str(i-1) + ".rle"
 
         g.save(fileNameRLE, "rle")
+        frame = get_frame()
         # Compare Previous Generation to Determine Class I Systems
-        if (i > 0 and compare_rle(fileNameRLE, fileNamePrevRLE)):
+        if (i > 0 and same_shape(frame, prevFrame)):
             break
+        prevFrame = frame
 
         g.run(1)
 
+    mark_done(g.getdir("rules") + generationDir, rule)
+
 # Close
 g.doevent("key q cmd")
@@ -16,13 +16,30 @@
 #include <string>
 #include <cmath>    
 #include "ConwayClassifier.h"
+#include "LifeSimulator.h"
+#include "HashLifeSimulator.h"
+#include "BatchSimulator.h"
+#ifdef CAGA_WITH_CUDA
+#include "GpuSimulator.h"
+#endif
+#include "ThreadPool.h"
+#include "BoundedQueue.h"
+#include "Instrumentation.h"
+#include "BoardArena.h"
+#include "FitnessCache.h"
+#include "Checkpoint.h"
+#include "RuleOracle.h"
+#include "Random.h"
+#include "RemoteWorkers.h"
+#include "GenerationDump.h"
 #include "rapidxml.hpp"
 
 using namespace std; 
 using namespace rapidxml;
 
-// Global Variables from XML Config
-int generation = 0; 
+// Global Variables from XML Config, only written by readConfig before any
+// worker threads are started so the workers can read them freely
+int generation = 0; // only touched by the main thread, see cal_PopFitness
 int populationSize;
 int elitismPercent;
 int crossoverRate;
@@ -31,6 +48,70 @@ int timeElapsed;
 int convergeGen;
 int maxThreadNum;
 int statCalcPercent;
+// stores every generation at its own bounding box in the ConwayClassifier
+bool sparseBoard;
+int gridSize;
+int gridFillPerc;
+unsigned int soupSeed;
+// every Ruleset is scored on soupCount Soups seeded soupSeed, soupSeed + 1,
+// ... and gets the mean of those Fitnesses less soupStdDevPenalty standard
+// deviations. With adaptiveSoups a Ruleset stops getting new Soups once it
+// has minSoupCount and the standard error of its mean is at most
+// maxSoupStdError. The Golly backend only ever uses one Soup
+int soupCount;
+bool adaptiveSoups;
+int minSoupCount;
+double maxSoupStdError;
+double soupStdDevPenalty;
+// "Native" simulates in-process, "HashLife" does too but jumps over the
+// Generations before the Stats, "Gpu" simulates and classifies the whole
+// Population on a CUDA device (builds with CAGA_WITH_CUDA only), "Golly"
+// runs golly-script.py through golly
+string simulationBackend;
+// number of golly processes the Golly backend runs at once, each simulating
+// the Rulesets golly_shard gives it into a directory of its own
+int gollyInstances;
+// "InterRule" evaluates several Individuals at once on workerThreadNum
+// threads, "IntraRule" evaluates them one at a time and lets each
+// ConwayClassifier use maxThreadNum threads instead, "Batch" simulates up
+// to 64 Individuals at once in a BatchSimulator on workerThreadNum threads
+// (Native backend only, the others fall back to "InterRule")
+string parallelMode;
+int workerThreadNum;
+bool fitnessCacheEnabled;
+// "" keeps the Fitness Cache in memory only
+string fitnessCacheFile;
+// write checkpointFile after every GA generation and resume from it
+bool checkpointEnabled;
+string checkpointFile;
+// "Local" simulates on this machine, "Coordinator" has the worker processes
+// at the comma separated "host:port"s of workerAddresses simulate every
+// Ruleset instead, "Worker" makes this process one of them, listening on
+// workerPort
+string distributedMode;
+int workerPort;
+string workerAddresses;
+// "Rle" has golly-script.py save a .rle file per Generation, "Dump" one
+// generation dump per Ruleset (see GenerationDump.h)
+string generationFormat;
+// compress the frames of the generation dumps written
+bool compressDumps;
+// if not "", the Native backend writes a generation dump of every Ruleset it
+// simulates to Generation_N in this directory, holding the same Generations
+// golly-script.py would save
+string nativeDumpDir;
+// with sweepEnabled every chromosome of sweepBand from sweepFirst through
+// sweepLast is classified on every Soup into oracleFile instead of running
+// the GA, with useOracle the GA looks Rulesets up in oracleFile before
+// simulating them. sweepBand "All" takes every chromosome, "SpecRule" only
+// the ones without birth or survival on 0 neighbours, like the Rules
+// generateSpecRule.py makes
+bool sweepEnabled;
+bool useOracle;
+string oracleFile;
+string sweepBand;
+int sweepFirst;
+int sweepLast;
 
 double activeWeight;
 double percentWeight;
@@ -42,9 +123,42 @@ double percentMax;
 double aliveMin;
 double aliveMax;
 
-// Possible characters to make up genome. Note that the genome is a binary
-// number represented as a string for simplicity.
-const string GENES = "01010"; // Testing different Ruleset Creation (2/5 Odds)
+// Number of genes in a genome. The genome is a binary number, gene i being
+// bit i, the first 9 genes are birth on 0-8 neighbours and the last 9
+// survival on 0-8, the way FitnessCache packs chromosomes
+const int GENE_COUNT = 18;
+const uint32_t GENE_MASK = (uint32_t(1) << GENE_COUNT) - 1;
+// Odds out of 5 of a new or mutated gene being 1
+const int GENE_ODDS = 2; // Testing different Ruleset Creation (2/5 Odds)
+
+// golly process each Ruleset of the current GA generation was given to,
+// only written by toFile before the generation's Fitness is calculated
+unordered_map<uint32_t, int> gollyShards;
+
+// Metrics of every Ruleset simulated so far, nullptr if caching is disabled
+FitnessCache* fitnessCache = nullptr;
+
+// Connections to the worker processes, nullptr unless distributedMode is
+// "Coordinator"
+RemoteWorkers* remoteWorkers = nullptr;
+
+// Metrics of the Rulesets a sweep has classified, nullptr unless useOracle
+RuleOracle* ruleOracle = nullptr;
+
+// Breeds the Population, its state can be saved in a checkpoint and carried
+// on with, which rand()'s can't
+Xoshiro256 rng;
+
+// builds with CAGA_INSTRUMENT write a line to instrumentFile for every
+// Ruleset classified and every GA generation, as "JSON" or "CSV"
+string instrumentFile;
+string instrumentFormat;
+// work of every Classifier of the current GA generation, and their time
+instrument::Counters generationCounters;
+double generationClassifySeconds = 0;
+// time spent waiting on Golly in the current GA generation
+double generationGollySeconds = 0;
+mutex instrumentLock;
 
 /**
  * Random number generator method
@@ -55,14 +169,18 @@ const string GENES = "01010"; // Testing different Ruleset Creation (2/5 Odds)
  */
 int random_num(int start, int end) { 
     int range = (end-start)+1; 
-    int random_int = start+(rand()%range); 
+    int random_int = start+rng.below(range); 
     return random_int; 
 } 
 
 /**
- * Dump created Rule Set files
+ * Dump created Rule Set files, unless the run is checkpointed since they are
+ * then what the checkpoint's generations were simulated from
  */
 void dump() {
+    if (checkpointEnabled) {
+        return;
+    }
     const char *command = "rm rule_sets*.txt";
     int result = system(command);
     if (result == -1)
@@ -70,72 +188,190 @@ void dump() {
 }
 
 /**
- * Decodes binary strings into golly rule sets
+ * Which of the golly processes simulates a Ruleset of the current GA
+ * generation, as toFile dealt them out
+ * 
+ * @param genes: the Ruleset's genome
+ * @return int shard from 0 to gollyInstances - 1
+ */
+int golly_shard(uint32_t genes) {
+    auto it = gollyShards.find(genes);
+    return it != gollyShards.end() ? it->second : 0;
+}
+
+/**
+ * Directory golly-script.py saves the Patterns of a GA generation in
  * 
- * @param chromosome: binary string
+ * @param gen: GA generation
+ * @param shard: golly process that simulated them
+ * @return string path of the directory
+ */
+string golly_generation_dir(int gen, int shard) {
+    // FilePath is a constant on the Virtual Machine
+    string dir = "/home/CellAutomataGA/Desktop/Golly Patterns/Simulation/Generation_" + to_string(gen);
+    if (gollyInstances > 1) {
+        dir += "/Shard_" + to_string(shard);
+    }
+    return dir;
+}
+
+/**
+ * Decodes genomes into golly rule sets
+ * 
+ * @param genes: packed genome
  * @return string golly rule set
  */
-string decode(string chromosome) {
-    string ruleSet = "";
-    ruleSet += "b";
+string decode(uint32_t genes) {
+    // "b012345678/s012345678" at most
+    char ruleSet[22];
+    int len = 0;
+    ruleSet[len++] = 'b';
     for(int i = 0; i < 9; i++) {
-        if (chromosome[i] == '1') {
-            ruleSet += to_string(i);
+        if (genes >> i & 1) {
+            ruleSet[len++] = '0' + i;
         }
     }
-    ruleSet += "/s";
-    for(int i = 9; i < 18; i++) {
-        if (chromosome[i] == '1') {
-            ruleSet += to_string(i - 9);
+    ruleSet[len++] = '/';
+    ruleSet[len++] = 's';
+    for(int i = 9; i < GENE_COUNT; i++) {
+        if (genes >> i & 1) {
+            ruleSet[len++] = '0' + i - 9;
         }
     }
-    return ruleSet;
+    return string(ruleSet, len);
 }
 
 /**
- * Encodes golly rule sets as binary strings
+ * Encodes golly rule sets as genomes
  * 
  * @param ruleSet: golly rule set string
- * @return string binary string
+ * @return uint32_t packed genome
  */
-string encode(string ruleSet) {
-    string chromosome = "000000000000000000";
+uint32_t encode(const string& ruleSet) {
+    uint32_t genes = 0;
     bool survive = false;
-    for(int i = 0; i < ruleSet.length(); i++) {
-        if (ruleSet[i] != 'b' && ruleSet[i] != 's') {
+    for(size_t i = 0; i < ruleSet.length(); i++) {
+        if (ruleSet[i] >= '0' && ruleSet[i] <= '8') {
             int index = ruleSet[i] - '0';
             if (survive) {
                 index += 9;
             }
-            chromosome[index] = '1';
+            genes |= uint32_t(1) << index;
         } else if (ruleSet[i] == 's') {
             survive = true;
         }
     }
+    return genes;
+}
+
+/**
+ * Unpacks a genome into the binary string the Simulators, the Fitness Cache
+ * and the workers take
+ * 
+ * @param genes: packed genome
+ * @return string binary string
+ */
+string unpack(uint32_t genes) {
+    string chromosome(GENE_COUNT, '0');
+    for(int i = 0; i < GENE_COUNT; i++) {
+        if (genes >> i & 1) {
+            chromosome[i] = '1';
+        }
+    }
     return chromosome;
 }
 
+/**
+ * Writes a line of Instrumentation to instrumentFile, from any thread. With
+ * CSV a header is written before the first line of each type
+ * 
+ * @param record: the line, its first field being its type
+ */
+void write_record(const instrument::Record& record) {
+    static ofstream out;
+    static set<string> headers;
+    lock_guard<mutex> guard(instrumentLock);
+    if (!out.is_open()) {
+        out.open(instrumentFile, ios::trunc);
+    }
+    if (instrumentFormat == "CSV") {
+        string header = record.csvHeader();
+        if (headers.insert(header).second) {
+            out << header << "\n";
+        }
+        out << record.toCsv() << endl;
+    } else {
+        out << record.toJson() << endl;
+    }
+}
+
+/**
+ * Writes the Instrumentation line of a Ruleset once its Classifier is done
+ * and adds its work to the GA generation's
+ * 
+ * @param c: the Classifier
+ * @param genes: the Ruleset
+ * @param gen: GA generation
+ * @param soup: which of the Soups it was simulated on
+ * @param seconds: time the Simulation and Classification took
+ */
+void write_rule_record(ConwayClassifier& c, uint32_t genes, int gen, int soup, double seconds) {
+    const ConwayClassifier::PhaseTimes& t = c.getPhaseTimes();
+    instrument::Record record;
+    record.add("type", "rule");
+    record.add("generation", gen);
+    record.add("rule", decode(genes));
+    record.add("soup", soup);
+    record.add("backend", simulationBackend);
+    record.add("class", (int) c.classification());
+    record.add("seconds", seconds);
+    record.add("readGens", t.readGens);
+    record.add("class1Check", t.class1Check);
+    record.add("class2Check", t.class2Check);
+    record.add("boardSpecs", t.boardSpecs);
+    record.add("allocateBoard", t.allocateBoard);
+    record.add("fillBoard", t.fillBoard);
+    record.add("activeCellRatio", t.activeCellRatio);
+    record.add("pushGenerations", t.pushGenerations);
+    record.add("", c.getCounters());
+    write_record(record);
+    generationCounters.add(c.getCounters());
+    lock_guard<mutex> guard(instrumentLock);
+    generationClassifySeconds += seconds;
+}
+
+/**
+ * Looks up the Metrics of a Ruleset found before, in the Rule Oracle and
+ * then in the Fitness Cache
+ * 
+ * @param genes: the Ruleset
+ * @param metrics: set to the Metrics if they are known
+ * @param soup: which of the Soups
+ * @return bool true if the Metrics are known
+ */
+bool known_metrics(uint32_t genes, RuleMetrics& metrics, int soup = 0) {
+    return (ruleOracle != nullptr && ruleOracle->lookup(genes, metrics, soup))
+        || (fitnessCache != nullptr && fitnessCache->lookup(genes, metrics, soup));
+}
+
 /**
  * Mutation function
  * 
- * @return char random 1 or 0 
+ * @return uint32_t random 1 or 0 
  */
-char mutated_genes() { 
-    int len = GENES.size(); 
-    int r = random_num(0, len-1); 
-    return GENES[r]; 
+uint32_t mutated_gene() { 
+    return random_num(0, 4) < GENE_ODDS; 
 } 
 
 /**
  * Creates new genome
  * 
- * @return string new genome
+ * @return uint32_t new packed genome
  */
-string create_gnome() { 
-    int len = 18; // Binary String Size 
-    string gnome = ""; 
-    for(int i = 0; i < len;i++) {
-        gnome += mutated_genes(); 
+uint32_t create_gnome() { 
+    uint32_t gnome = 0; 
+    for(int i = 0; i < GENE_COUNT; i++) {
+        gnome |= mutated_gene() << i; 
     }
     return gnome; 
 } 
@@ -145,20 +381,24 @@ string create_gnome() {
  */
 class Individual { 
 public: 
-    string chromosome; 
+    uint32_t genes; 
     double fitness; 
-    Individual(string chromosome); 
-    Individual mate(Individual parent2); 
-    double cal_fitness(); 
+    explicit Individual(uint32_t genes); 
+    Individual mate(const Individual& parent2) const; 
+    string chromosome() const; 
+    double cal_fitness(int gen, int classifierThreadNum, int soup) const; 
+    double cal_fitness(const RuleMetrics& metrics) const; 
+    RuleMetrics cal_metrics(int gen, int classifierThreadNum, int soup) const; 
 }; 
 
 /**
- * Constructor that takes in a chromosome
+ * Constructor that takes in a packed chromosome
  * 
- * @param chromosome chromosome to be associated with individual
+ * @param genes chromosome to be associated with individual
  */
-Individual::Individual(string chromosome) { 
-    this->chromosome = chromosome; 
+Individual::Individual(uint32_t genes) { 
+    this->genes = genes; 
+    this->fitness = 0; 
 }; 
 
 /**
@@ -167,41 +407,140 @@ Individual::Individual(string chromosome) {
  * @param par2: Second Individual used in crossover
  * @return Individual the child for new generation
  */
-Individual Individual::mate(Individual par2) { 
-    string child_chromosome = ""; 
-    int len = chromosome.size(); 
-    // Determine Chromosome based on Parents and Mutation Rate
-    for(int i = 0; i < len; i++) {
+Individual Individual::mate(const Individual& par2) const { 
+    const float firstOdds = (float)(100-mutationRate)/200;
+    const float secondOdds = (float)(100-mutationRate)/100;
+    // Determine which genes come from which Parent based on the Mutation
+    // Rate, then take them from both at once
+    uint32_t fromSecond = 0;
+    uint32_t mutated = 0;
+    uint32_t mutation = 0;
+    for(int i = 0; i < GENE_COUNT; i++) {
         float p = random_num(0, 100)/100.;
-        if(p < (float)(100-mutationRate)/200) {
-            child_chromosome += chromosome[i]; 
-        } else if(p < (float)(100-mutationRate)/100) {
-            child_chromosome += par2.chromosome[i]; 
+        if(p < firstOdds) {
+            continue;
+        } else if(p < secondOdds) {
+            fromSecond |= uint32_t(1) << i;
         } else {
-            child_chromosome += mutated_genes(); 
+            mutated |= uint32_t(1) << i;
+            mutation |= mutated_gene() << i;
         }
     }
-    return Individual(child_chromosome); 
+    const uint32_t fromFirst = GENE_MASK & ~(fromSecond | mutated);
+    return Individual((this->genes & fromFirst) | (par2.genes & fromSecond) | mutation); 
 }; 
 
 /**
- * Calculates the fitness of the Individual
+ * The Individual's chromosome as a binary string
  * 
- * @return int fitness number
+ * @return string binary string
  */
-double Individual::cal_fitness() {
-    // FilePath is a constant on the Virtual Machine
-    string filePath = "/home/CellAutomataGA/Desktop/Golly Patterns/Simulation/Generation_" + to_string(generation);
+string Individual::chromosome() const { 
+    return unpack(this->genes); 
+}; 
+
+/**
+ * Simulates the Individual's Ruleset and calculates its Metrics. Only reads
+ * the config globals so it can be run for several Individuals at once
+ * 
+ * @param gen: GA generation the Individual belongs to
+ * @param classifierThreadNum: number of threads the classifier may use
+ * @param soup: which of the Soups to simulate, ignored by Golly
+ * @return RuleMetrics the Classifier's Metrics and Classification
+ */
+RuleMetrics Individual::cal_metrics(int gen, int classifierThreadNum, int soup) const {
     // Rename Decoded Chromosome
-    string fileName = decode(this->chromosome);
+    string fileName = decode(this->genes);
     std::replace(fileName.begin(), fileName.end(), '/', '_');
     // Create CC Object 
-    ConwayClassifier c(filePath + "/" + fileName, timeElapsed, maxThreadNum, statCalcPercent);
+    unique_ptr<ConwayClassifier> c;
+    double seconds = 0;
+    if (simulationBackend == "Golly") {
+        CAGA_TIME(seconds);
+        string dataPath = golly_generation_dir(gen, golly_shard(this->genes)) + "/" + fileName;
+        if (generationFormat == "Dump") {
+            dataPath += ".gdump";
+        }
+        c.reset(new ConwayClassifier(dataPath, timeElapsed, classifierThreadNum, statCalcPercent, sparseBoard));
+    } else {
+        // Simulate in-process and stream each Generation to the Classifier
+        // as it is made, so only the last few are ever held in memory
+        CAGA_TIME(seconds);
+        unique_ptr<SimulationEngine> sim;
+        const unsigned int seed = soupSeed + soup;
+        c.reset(new ConwayClassifier(fileName, timeElapsed, statCalcPercent));
+        int firstFrameGen = 0;
+        if (simulationBackend == "HashLife") {
+            sim.reset(new HashLifeSimulator(this->chromosome(), gridSize, gridFillPerc, seed));
+            // Jump straight to the Generations the Stats are taken from
+            firstFrameGen = c->getFirstNeededGen();
+            c->skipGenerations(firstFrameGen);
+        } else {
+            sim.reset(new LifeSimulator(this->chromosome(), gridSize, gridFillPerc, seed));
+        }
+        unique_ptr<GenerationDumpWriter> dump;
+        if (nativeDumpDir != "" && simulationBackend == "Native") {
+            string dumpDir = nativeDumpDir + "/Generation_" + to_string(gen);
+            std::error_code error; // another worker may be making it too
+            filesystem::create_directories(dumpDir, error);
+            string dumpName = soup == 0 ? fileName : fileName + "_soup" + to_string(soup);
+            dump.reset(new GenerationDumpWriter(dumpDir + "/" + dumpName + ".gdump", fileName, compressDumps));
+        }
+        // Stop as soon as the Rule cycles, the rest could only be repeats.
+        // A dump has to hold every Generation golly would save, so it only
+        // stops where golly-script.py does
+        sim->run(timeElapsed, [&](const GenerationFrame& frame) {
+            c->pushGeneration(frame);
+            if (dump) {
+                dump->write(frame);
+            }
+        }, !dump, firstFrameGen);
+        if (dump) {
+            dump->close();
+        }
+        c->finishGenerations(sim->getSettledClass() == 2);
+    }
+    if (instrument::enabled) {
+        write_rule_record(*c, this->genes, gen, soup, seconds);
+    }
+    return {c->getAliveCellRatio(), c->getPercentChange(),
+        c->getActiveCellRatio(), c->classification()};
+}
+
+/**
+ * Calculates the fitness of the Individual on one Soup, reusing the Metrics
+ * from the Rule Oracle or the Fitness Cache if the Ruleset has been
+ * simulated on it before
+ * 
+ * @param gen: GA generation the Individual belongs to
+ * @param classifierThreadNum: number of threads the classifier may use
+ * @param soup: which of the Soups to simulate
+ * @return int fitness number
+ */
+double Individual::cal_fitness(int gen, int classifierThreadNum, int soup) const {
+    RuleMetrics metrics;
+    if (!known_metrics(this->genes, metrics, soup)) {
+        metrics = remoteWorkers != nullptr ? remoteWorkers->evaluate(this->chromosome(), gen, soup)
+            : this->cal_metrics(gen, classifierThreadNum, soup);
+        if (fitnessCache != nullptr) {
+            fitnessCache->store(this->genes, metrics, soup);
+        }
+    }
+    return this->cal_fitness(metrics);
+}
 
+/**
+ * Calculates the fitness of the Individual from its Ruleset's Metrics
+ * 
+ * @param metrics: the Classifier's Metrics and Classification
+ * @return int fitness number
+ */
+double Individual::cal_fitness(const RuleMetrics& metrics) const {
     // Calculate Metrics and Weights
-    double aliveCell = c.getAliveCellRatio();
-    double percentChange = c.getPercentChange();
-    double activeCell = c.getActiveCellRatio();
+    double aliveCell = metrics.aliveCell;
+    double percentChange = metrics.percentChange;
+    double activeCell = metrics.activeCell;
+    unsigned short int classNum = metrics.classNum;
 
     double aliveValue = 0;
     double percentValue = 0;
@@ -222,9 +561,65 @@ double Individual::cal_fitness() {
     }
     
      // Return Fitness Value with Weights from Config File
-    return c.classification() + (aliveWeight * aliveValue) + (percentWeight * percentValue) + (activeWeight * activeValue);
+    return classNum + (aliveWeight * aliveValue) + (percentWeight * percentValue) + (activeWeight * activeValue);
 }; 
 
+/**
+ * Sample standard deviation of the Fitnesses an Individual got on its Soups
+ * 
+ * @param soupFitness: Fitness on each Soup so far
+ * @return double the standard deviation, 0 with fewer than two Soups
+ */
+double soup_stddev(const vector<double>& soupFitness) {
+    const size_t n = soupFitness.size();
+    if (n < 2) {
+        return 0;
+    }
+    double mean = 0;
+    for(double f : soupFitness) {
+        mean += f;
+    }
+    mean /= n;
+    double squares = 0;
+    for(double f : soupFitness) {
+        squares += (f - mean) * (f - mean);
+    }
+    return sqrt(squares / (n - 1));
+}
+
+/**
+ * Combines the Fitnesses an Individual got on its Soups into its Fitness
+ * 
+ * @param soupFitness: Fitness on each Soup
+ * @return double the mean Fitness less soupStdDevPenalty standard deviations
+ */
+double aggregate_fitness(const vector<double>& soupFitness) {
+    double mean = 0;
+    for(double f : soupFitness) {
+        mean += f;
+    }
+    mean /= soupFitness.size();
+    return mean - soupStdDevPenalty * soup_stddev(soupFitness);
+}
+
+/**
+ * Decides whether an Individual should be scored on another Soup
+ * 
+ * @param soupFitness: Fitness on each Soup so far
+ * @return bool true if it has fewer than soupCount Soups and, in adaptive
+ *         mode, fewer than minSoupCount or a mean that's still too uncertain
+ */
+bool needs_soup(const vector<double>& soupFitness) {
+    const int n = soupFitness.size();
+    if (n >= soupCount) {
+        return false;
+    }
+    if (!adaptiveSoups || n < minSoupCount) {
+        return true;
+    }
+    return soup_stddev(soupFitness) / sqrt((double) n) > maxSoupStdError;
+}
+
 /**
  * Operator override for sort function allowing the sort function to apply
  * to our custom Individual class
@@ -239,57 +634,580 @@ bool operator<(const Individual &ind1, const Individual &ind2) {
 } 
 
 /**
- * Method to save population of rule sets to a text file
+ * Method to save population of rule sets to a text file. Rule sets whose
+ * Metrics are already cached, and repeats, are left out so Golly doesn't
+ * simulate them again. With several golly processes the Rule sets are dealt
+ * out in turn, each process getting a file of its own,
+ * rule_sets<gen>_<shard>.txt
  * 
  * @param population Rule sets to save
  */
-void toFile(vector<Individual> population, int gen) {
-    ofstream out;
-    string str = "rule_sets" + to_string(gen) + ".txt"; 
-    out.open(str);
-    for(int i = 0; i < population.size(); i++) {
-        out << decode(population[i].chromosome) << endl;
+void toFile(const vector<Individual> &population, int gen) {
+    vector<ofstream> out(gollyInstances);
+    for(int shard = 0; shard < gollyInstances; shard++) {
+        string str = "rule_sets" + to_string(gen);
+        if (gollyInstances > 1) {
+            str += "_" + to_string(shard);
+        }
+        out[shard].open(str + ".txt");
+    }
+    gollyShards.clear();
+    RuleMetrics metrics;
+    for(size_t i = 0; i < population.size(); i++) {
+        if (known_metrics(population[i].genes, metrics)) {
+            continue;
+        }
+        const int shard = gollyShards.size() % gollyInstances;
+        if (gollyShards.emplace(population[i].genes, shard).second) {
+            out[shard] << decode(population[i].genes) << endl;
+        }
+    }
+    for(ofstream& o : out) {
+        o.close();
     }
-    out.close();
 }
 
 /**
  * Method to Fork and Run Golly or Fork and Run a 
- * Python Script that resets 'CurrentGeneration' field
+ * Python Script that resets 'CurrentGeneration' field. The reset is waited
+ * for, Golly is left running so its Rulesets can be classified while it
+ * simulates the rest. Golly is told which GA generation and shard to
+ * simulate through its environment, since golly can't pass arguments to a
+ * script, so that several of them never race on 'CurrentGeneration'
  * 
  * @param reset To determine if Configuration XML needs reset
+ * @param resetGen Generation 'CurrentGeneration' is reset to, or the
+ * generation Golly simulates
+ * @param shard Shard of the generation's Rulesets Golly simulates
+ * @return pid_t process id of Golly, which the caller has to wait for
  */
-void generatePatterns(bool reset) {
+pid_t generatePatterns(bool reset, int resetGen = 0, int shard = 0) {
+    // Built before forking, the child of a threaded process shouldn't
+    // allocate
+    const string genText = to_string(resetGen);
+    vector<string> settings = {"CAGA_GOLLY_GENERATION=" + genText,
+        "CAGA_GOLLY_SHARD=" + to_string(shard)};
+    vector<char*> env;
+    for(char** e = environ; *e != nullptr; e++) {
+        env.push_back(*e);
+    }
+    for(string& setting : settings) {
+        env.push_back(&setting[0]);
+    }
+    env.push_back(nullptr);
+    char* const args[] = {(char*) "golly", (char*) "golly-script.py", nullptr};
     const int pid= fork();
     if (reset) {
         if (pid== 0) {
-            execlp("python3", "python3", "resetXML.py", nullptr);
+            execlp("python3", "python3", "resetXML.py", genText.c_str(), nullptr);
         } else {
             waitpid(pid, nullptr, 0);
         }
     } else {
         if (pid== 0) {
-            execlp("golly", "golly", "golly-script.py", nullptr);
+            execvpe("golly", args, env.data());
+            _exit(127);
+        }
+    }
+    return pid;
+}
+
+/**
+ * Method to Calculate the Fitness of some Individuals with the Golly
+ * backend while Golly is still simulating them. gollyInstances golly
+ * processes simulate a shard of the Rulesets each, golly-script.py writing a
+ * marker file once it has saved every Generation of a Ruleset. A producer
+ * thread watches for those markers and hands each finished Ruleset through a
+ * bounded queue to the Classifiers, on the pool's workers or on this thread
+ * in IntraRule mode. Only Rulesets that aren't cached are waited for
+ * 
+ * @param population Vector of Individuals
+ * @param todo Indices of the Individuals to calculate
+ * @param pool Worker Pool for InterRule mode, nullptr for IntraRule mode
+ * @return vector<double> Fitness of each Individual in todo, in order
+ */
+vector<double> cal_GollyFitness(const vector<Individual> &population, const vector<size_t> &todo, ThreadPool* pool) {
+    const int gen = generation;
+    vector<double> fitness(todo.size());
+    // Positions in todo of every Ruleset Golly simulates, by file name
+    map<string, vector<size_t>> waiting;
+    // golly process simulating each of them
+    map<string, int> shardOf;
+    RuleMetrics metrics;
+    for(size_t t = 0; t < todo.size(); t++) {
+        const Individual& ind = population[todo[t]];
+        if (known_metrics(ind.genes, metrics)) {
+            fitness[t] = ind.cal_fitness(metrics);
+            continue;
+        }
+        string fileName = decode(ind.genes);
+        std::replace(fileName.begin(), fileName.end(), '/', '_');
+        waiting[fileName].push_back(t);
+        shardOf[fileName] = golly_shard(ind.genes);
+    }
+    // Markers left over from an earlier run would look finished already
+    vector<string> genDirs;
+    for(int shard = 0; shard < gollyInstances; shard++) {
+        genDirs.push_back(golly_generation_dir(gen, shard));
+    }
+    std::error_code error;
+    for(auto& w : waiting) {
+        filesystem::remove(genDirs[shardOf[w.first]] + "/" + w.first + ".done", error);
+    }
+    CAGA_TIME(generationGollySeconds);
+    vector<pid_t> pids;
+    for(int shard = 0; shard < gollyInstances; shard++) {
+        pids.push_back(generatePatterns(false, gen, shard));
+    }
+    const int consumerNum = pool != nullptr ? pool->size() : 1;
+    // Rulesets are only names in the queue, the bound keeps Golly from
+    // getting far ahead of the Classifiers
+    BoundedQueue<string> ready(2 * consumerNum);
+    vector<bool> gollyDone(gollyInstances, false);
+    thread producer([&]() {
+        set<string> left;
+        for(auto& w : waiting) {
+            left.insert(w.first);
+        }
+        while (!left.empty()) {
+            for(int shard = 0; shard < gollyInstances; shard++) {
+                if (!gollyDone[shard]) {
+                    gollyDone[shard] = waitpid(pids[shard], nullptr, WNOHANG) == pids[shard];
+                }
+            }
+            for(auto it = left.begin(); it != left.end();) {
+                // Once its Golly is gone nothing else of the shard will
+                // finish, the Classifier decides what the rest are
+                const int shard = shardOf.at(*it);
+                std::error_code markerError;
+                if (gollyDone[shard] || filesystem::exists(genDirs[shard] + "/" + *it + ".done", markerError)) {
+                    if (!ready.push(*it)) {
+                        return; // the Classifiers gave up
+                    }
+                    it = left.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (!left.empty()) {
+                this_thread::sleep_for(chrono::milliseconds(20));
+            }
+        }
+        ready.close();
+    });
+    // Individuals sharing a Ruleset are classified once and share the Fitness
+    auto consume = [&](int classifierThreadNum) {
+        string fileName;
+        try {
+            while (ready.pop(fileName)) {
+                const vector<size_t>& positions = waiting.at(fileName);
+                const double f = population[todo[positions[0]]].cal_fitness(gen, classifierThreadNum, 0);
+                for(size_t t : positions) {
+                    fitness[t] = f;
+                }
+            }
+        } catch (...) {
+            ready.close();
+            throw;
+        }
+    };
+    exception_ptr firstError;
+    try {
+        if (pool != nullptr) {
+            for(int i = 0; i < consumerNum; i++) {
+                pool->submit([&consume]() {
+                    consume(1);
+                });
+            }
+            pool->wait();
         } else {
-            waitpid(pid, nullptr, 0);
+            consume(maxThreadNum);
+        }
+    } catch (...) {
+        firstError = current_exception();
+        ready.close();
+    }
+    producer.join();
+    for(int shard = 0; shard < gollyInstances; shard++) {
+        if (!gollyDone[shard]) {
+            waitpid(pids[shard], nullptr, 0);
         }
     }
+    if (firstError) {
+        rethrow_exception(firstError);
+    }
+    return fitness;
+}
+
+/**
+ * Method to Calculate the Fitness of some Individuals on one Soup with the
+ * BatchSimulator, or the GpuSimulator for the Gpu backend. Rulesets that
+ * aren't cached yet are simulated up to 64 at a time on the Soup, each one
+ * streaming its Generations to a Classifier of its own, or all at once on
+ * the GPU
+ * 
+ * @param population Vector of Individuals
+ * @param todo Indices of the Individuals to calculate
+ * @param soup Which of the Soups to simulate
+ * @return vector<double> Fitness of each Individual in todo, in order
+ */
+vector<double> cal_BatchFitness(const vector<Individual> &population, const vector<size_t> &todo, int soup) {
+    const unsigned int seed = soupSeed + soup;
+    unordered_map<uint32_t, RuleMetrics> metricsOf;
+    vector<uint32_t> pending;
+    unordered_set<uint32_t> seen;
+    RuleMetrics metrics;
+    for(size_t t : todo) {
+        const Individual& i = population[t];
+        if (!seen.insert(i.genes).second) {
+            continue;
+        }
+        if (known_metrics(i.genes, metrics, soup)) {
+            metricsOf[i.genes] = metrics;
+        } else {
+            pending.push_back(i.genes);
+        }
+    }
+#ifdef CAGA_WITH_CUDA
+    if (simulationBackend == "Gpu") {
+        // Only the Metrics of each Ruleset come back from the device
+        vector<string> chromosomes;
+        for(uint32_t genes : pending) {
+            chromosomes.push_back(unpack(genes));
+        }
+        GpuSimulator sim(chromosomes, gridSize, gridFillPerc, seed);
+        vector<RuleMetrics> found = sim.run(timeElapsed, statCalcPercent);
+        for(size_t r = 0; r < pending.size(); r++) {
+            metricsOf[pending[r]] = found[r];
+            if (fitnessCache != nullptr) {
+                fitnessCache->store(pending[r], found[r], soup);
+            }
+        }
+        pending.clear();
+    }
+#endif
+    const int threadNum = workerThreadNum > 0 ? workerThreadNum
+        : max(1u, thread::hardware_concurrency());
+    for(size_t first = 0; first < pending.size(); first += BatchSimulator::maxRuleCount) {
+        const size_t last = min(pending.size(), first + BatchSimulator::maxRuleCount);
+        // The Simulators take binary strings
+        vector<string> batch;
+        vector<unique_ptr<ConwayClassifier>> classifiers;
+        for(size_t r = first; r < last; r++) {
+            batch.push_back(unpack(pending[r]));
+            string fileName = decode(pending[r]);
+            std::replace(fileName.begin(), fileName.end(), '/', '_');
+            classifiers.emplace_back(new ConwayClassifier(fileName, timeElapsed, statCalcPercent));
+        }
+        // Each Ruleset's Generations only ever go to its own Classifier, so
+        // the Classifiers can be fed from several threads at once
+        double seconds = 0;
+        BatchSimulator sim(batch, gridSize, gridFillPerc, seed);
+        {
+            CAGA_TIME(seconds);
+            sim.run(timeElapsed, [&](const int rule, const GenerationFrame& frame) {
+                classifiers[rule]->pushGeneration(frame);
+            }, true, threadNum);
+        }
+        for(size_t r = 0; r < batch.size(); r++) {
+            ConwayClassifier& c = *classifiers[r];
+            c.finishGenerations(sim.getSettledClass(r) == 2);
+            // The Rulesets of a batch share its time
+            if (instrument::enabled) {
+                write_rule_record(c, pending[first + r], generation, soup, seconds / batch.size());
+            }
+            metrics = {c.getAliveCellRatio(), c.getPercentChange(),
+                c.getActiveCellRatio(), c.classification()};
+            metricsOf[pending[first + r]] = metrics;
+            if (fitnessCache != nullptr) {
+                fitnessCache->store(pending[first + r], metrics, soup);
+            }
+        }
+    }
+    vector<double> fitness;
+    for(size_t t : todo) {
+        fitness.push_back(population[t].cal_fitness(metricsOf[population[t].genes]));
+    }
+    return fitness;
 }
 
 /**
  * Method to Iterate over Population and Calculate Fitness
- * after Simulation.
+ * after Simulation. Soups are handed out one round at a time to every
+ * Individual that still needs one, so in adaptive mode the Individuals that
+ * are settled drop out while the rest get another. The Golly backend
+ * classifies each Ruleset as soon as Golly has finished it, the Gpu backend
+ * and the Native backend in Batch mode simulate a round in lockstep, with a pool
+ * every Individual is its own task, otherwise they are evaluated one after
+ * another.
  * 
  * @param population Vector of Individuals
+ * @param pool Worker Pool for InterRule mode, nullptr for IntraRule mode
  */
-void cal_PopFitness(vector<Individual> &population) {
-    for(Individual& i : population) {
-        i.fitness = i.cal_fitness();
-        // Print each Individual's Fitness
-        printf("%8s%27s%13s%5.3f\n", "Ruleset: ", decode(i.chromosome).c_str(), "Fitness: ", i.fitness);
+void cal_PopFitness(vector<Individual> &population, ThreadPool* pool) {
+    // Copy the generation so the workers never read the global while the
+    // main thread could be changing it
+    const int gen = generation;
+    vector<vector<double>> soupFitness(population.size());
+    for(int soup = 0; soup < soupCount; soup++) {
+        vector<size_t> todo;
+        for(size_t i = 0; i < population.size(); i++) {
+            if (needs_soup(soupFitness[i])) {
+                todo.push_back(i);
+            }
+        }
+        if (todo.empty()) {
+            break;
+        }
+        if (simulationBackend == "Golly" || simulationBackend == "Gpu"
+                || (parallelMode == "Batch" && simulationBackend == "Native")) {
+            vector<double> fitness = simulationBackend == "Golly" ? cal_GollyFitness(population, todo, pool)
+                : cal_BatchFitness(population, todo, soup);
+            for(size_t t = 0; t < todo.size(); t++) {
+                soupFitness[todo[t]].push_back(fitness[t]);
+            }
+        } else if (pool != nullptr) {
+            // Each task only adds to the Soup Fitnesses of its own Individual
+            for(size_t i : todo) {
+                const Individual* ind = &population[i];
+                vector<double>* fitness = &soupFitness[i];
+                pool->submit([ind, fitness, gen, soup]() {
+                    fitness->push_back(ind->cal_fitness(gen, 1, soup));
+                });
+            }
+            pool->wait();
+        } else {
+            for(size_t i : todo) {
+                soupFitness[i].push_back(population[i].cal_fitness(gen, maxThreadNum, soup));
+            }
+        }
+    }
+    for(size_t i = 0; i < population.size(); i++) {
+        population[i].fitness = aggregate_fitness(soupFitness[i]);
+    }
+    // Print each Individual's Fitness in Population order once all are in
+    for(size_t i = 0; i < population.size(); i++) {
+        const Individual& ind = population[i];
+        if (soupCount > 1) {
+            printf("%8s%27s%13s%5.3f%11s%5.3f%9s%d\n", "Ruleset: ", decode(ind.genes).c_str(), "Fitness: ", ind.fitness,
+                "Std Dev: ", soup_stddev(soupFitness[i]), "Soups: ", (int) soupFitness[i].size());
+        } else {
+            printf("%8s%27s%13s%5.3f\n", "Ruleset: ", decode(ind.genes).c_str(), "Fitness: ", ind.fitness);
+        }
+    }
+}
+
+/**
+ * Method to Calculate the Fitness of a GA generation, saving the Rulesets to
+ * simulate first and the Fitness Cache and Instrumentation after
+ * 
+ * @param population Vector of Individuals
+ * @param pool Worker Pool for InterRule mode, nullptr otherwise
+ */
+void evaluate_generation(vector<Individual> &population, ThreadPool* pool) {
+    toFile(population, generation);
+    double fitnessSeconds = 0;
+    {
+        CAGA_TIME(fitnessSeconds);
+        cal_PopFitness(population, pool);
+    }
+    if (fitnessCache != nullptr) {
+        fitnessCache->save();
+    }
+    if (instrument::enabled) {
+        instrument::Record record;
+        record.add("type", "generation");
+        record.add("generation", generation);
+        record.add("backend", simulationBackend);
+        record.add("population", (int) population.size());
+        record.add("cached", fitnessCache != nullptr ? fitnessCache->size() : 0);
+        record.add("seconds", fitnessSeconds);
+        record.add("gollySeconds", generationGollySeconds);
+        record.add("classifySeconds", generationClassifySeconds);
+        record.add("", generationCounters);
+        write_record(record);
+        generationCounters.reset();
+        generationClassifySeconds = 0;
+        generationGollySeconds = 0;
     }
 }
 
+/**
+ * Method to write the checkpoint of a GA generation whose Fitness has been
+ * calculated, along with the generator that breeds the next one
+ * 
+ * @param population Vector of Individuals
+ * @param runKey Parameters of the run
+ */
+void save_checkpoint(const vector<Individual> &population, const string &runKey) {
+    Checkpoint checkpoint;
+    checkpoint.runKey = runKey;
+    checkpoint.generation = generation;
+    checkpoint.soupSeed = soupSeed;
+    ostringstream state;
+    state << rng;
+    checkpoint.rngState = state.str();
+    checkpoint.geneCount = GENE_COUNT;
+    for(const Individual& ind : population) {
+        checkpoint.chromosomes.push_back(ind.genes);
+        checkpoint.fitness.push_back(ind.fitness);
+    }
+    if (fitnessCache != nullptr) {
+        ostringstream entries;
+        fitnessCache->saveTo(entries);
+        checkpoint.cacheEntries = entries.str();
+    }
+    checkpoint.save(checkpointFile);
+}
+
+/**
+ * Method to classify every chromosome of the sweep's band on every Soup into
+ * the Rule Oracle instead of running the GA. Each chromosome is a task on
+ * the pool's workers, which simulate it in-process or send it to the
+ * remote workers. The oracle is saved after every block of chromosomes and
+ * chromosomes it already holds are skipped, so a stopped sweep carries on
+ * where it was and sweeps of other bands add to the same file
+ * 
+ * @param oracle Rule Oracle to fill
+ * @param pool Worker Pool
+ */
+void sweep_rules(RuleOracle &oracle, ThreadPool* pool) {
+    const uint32_t first = max(0, sweepFirst);
+    const uint32_t last = min((uint32_t) sweepLast, RuleOracle::ruleCount - 1);
+    // birth on 0 is gene 0 and survival on 0 gene 9
+    const uint32_t zeroGenes = (uint32_t(1) << 0) | (uint32_t(1) << 9);
+    vector<uint32_t> band;
+    for(uint32_t genes = first; genes <= last && first <= last; genes++) {
+        if (sweepBand == "SpecRule" && (genes & zeroGenes) != 0) {
+            continue;
+        }
+        band.push_back(genes);
+    }
+    const size_t blockSize = 16384;
+    long long int done = 0;
+    const long long int total = (long long int) band.size() * oracle.getSoupCount();
+    printf("%8s%lld\n", "Rulesets to Sweep: ", total);
+    for(size_t start = 0; start < band.size(); start += blockSize) {
+        const size_t end = min(band.size(), start + blockSize);
+        for(int soup = 0; soup < oracle.getSoupCount(); soup++) {
+            RuleMetrics metrics;
+            for(size_t b = start; b < end; b++) {
+                const uint32_t genes = band[b];
+                if (oracle.lookup(genes, metrics, soup)) {
+                    continue;
+                }
+                // Each task only sets the record of its own chromosome
+                pool->submit([&oracle, genes, soup]() {
+                    RuleMetrics found = remoteWorkers != nullptr
+                        ? remoteWorkers->evaluate(unpack(genes), 0, soup)
+                        : Individual(genes).cal_metrics(0, 1, soup);
+                    oracle.store(genes, found, soup);
+                });
+            }
+        }
+        pool->wait();
+        oracle.save();
+        done += (long long int) (end - start) * oracle.getSoupCount();
+        printf("%8s%lld%s%lld\n", "Swept Rulesets: ", done, " of ", total);
+        fflush(stdout);
+    }
+}
+
+/**
+ * Simulation parameters a coordinator sends its workers, every config value
+ * the Metrics of a Ruleset depend on
+ * 
+ * @return string the parameters separated by spaces
+ */
+string simulation_params() {
+    return simulationBackend + " " + to_string(soupSeed) + " " + to_string(gridSize) + " "
+        + to_string(gridFillPerc) + " " + to_string(timeElapsed) + " " + to_string(statCalcPercent);
+}
+
+// Parameters the Worker simulates with and the number of connections that
+// sent them, the globals are only changed while no connection uses them
+string workerParams;
+int workerConnections = 0;
+mutex workerLock;
+
+/**
+ * Method to answer one line a coordinator sent to this Worker, see
+ * RemoteWorkers.h for the protocol
+ * 
+ * @param line The line without its '\n'
+ * @param state Parameters the connection sent, "" until it sends them
+ * @return string the reply
+ */
+string worker_reply(const string& line, string& state) {
+    if (line.compare(0, 7, "PARAMS ") == 0) {
+        const string params = line.substr(7);
+        lock_guard<mutex> guard(workerLock);
+        if (state != "") {
+            return "ERR PARAMS sent twice";
+        }
+        if (workerConnections > 0 && params != workerParams) {
+            return "ERR Busy with other parameters";
+        }
+        if (workerConnections == 0) {
+            istringstream in(params);
+            string backend;
+            if (!(in >> backend >> soupSeed >> gridSize >> gridFillPerc >> timeElapsed >> statCalcPercent)) {
+                return "ERR Malformed PARAMS";
+            }
+            // Only the in-process backends simulate one Ruleset at a time
+            if (backend != "Native" && backend != "HashLife") {
+                return "ERR Backend not supported by workers";
+            }
+            simulationBackend = backend;
+            workerParams = params;
+        }
+        workerConnections++;
+        state = params;
+        return "OK";
+    }
+    if (line.compare(0, 5, "EVAL ") == 0) {
+        if (state == "") {
+            return "ERR PARAMS not sent";
+        }
+        istringstream in(line.substr(5));
+        int gen;
+        int soup;
+        string chromosome;
+        if (!(in >> gen >> soup >> chromosome) || chromosome.length() != 18
+                || chromosome.find_first_not_of("01") != string::npos) {
+            return "ERR Malformed EVAL";
+        }
+        try {
+            RuleMetrics metrics = Individual(FitnessCache::packChromosome(chromosome)).cal_metrics(gen, 1, soup);
+            char reply[128];
+            snprintf(reply, sizeof(reply), "%.17g %.17g %.17g %d", metrics.aliveCell,
+                metrics.percentChange, metrics.activeCell, (int) metrics.classNum);
+            return reply;
+        } catch (const char* error) {
+            return string("ERR ") + error;
+        } catch (const exception& error) {
+            return string("ERR ") + error.what();
+        } catch (...) {
+            return "ERR Could not evaluate the Ruleset";
+        }
+    }
+    return "ERR Unknown message";
+}
+
+/**
+ * Method to run this process as a Worker until it is killed
+ */
+void serve_worker() {
+    printf("%8s%d\n", "Worker listening on port: ", workerPort);
+    fflush(stdout);
+    RemoteWorkers::serve(workerPort, worker_reply, [](const string& state) {
+        if (state != "") {
+            lock_guard<mutex> guard(workerLock);
+            workerConnections--;
+        }
+    });
+}
+
 /**
  *  Method to read and assign Global Variables based on System-wide Config File
  * 
@@ -313,6 +1231,38 @@ void readConfig() {
     convergeGen = atoi(root_node->first_node("GeneticAlgo")->first_node("ConvergeGen")->value());
     maxThreadNum = atoi(root_node->first_node("ConwayClassifier")->first_node("MaxThreadNumber")->value());
     statCalcPercent = atoi(root_node->first_node("ConwayClassifier")->first_node("StatCalculationPercent")->value());
+    sparseBoard = atoi(root_node->first_node("ConwayClassifier")->first_node("SparseBoard")->value()) != 0;
+    BoardArena::setKeepLimit(atoll(root_node->first_node("ConwayClassifier")->first_node("BoardArenaMB")->value()) << 20);
+    gridSize = atoi(root_node->first_node("CellAutomata")->first_node("StartingGrid")->first_node("GridSize")->value());
+    gridFillPerc = atoi(root_node->first_node("CellAutomata")->first_node("StartingGrid")->first_node("GridFillPerc")->value());
+    soupSeed = strtoul(root_node->first_node("CellAutomata")->first_node("StartingGrid")->first_node("Seed")->value(), nullptr, 10);
+    soupCount = atoi(root_node->first_node("CellAutomata")->first_node("StartingGrid")->first_node("SoupCount")->value());
+    adaptiveSoups = atoi(root_node->first_node("CellAutomata")->first_node("StartingGrid")->first_node("AdaptiveSoups")->first_node("Enabled")->value()) != 0;
+    minSoupCount = atoi(root_node->first_node("CellAutomata")->first_node("StartingGrid")->first_node("AdaptiveSoups")->first_node("MinSoupCount")->value());
+    maxSoupStdError = atof(root_node->first_node("CellAutomata")->first_node("StartingGrid")->first_node("AdaptiveSoups")->first_node("MaxStdError")->value());
+    soupStdDevPenalty = atof(root_node->first_node("CellAutomata")->first_node("StartingGrid")->first_node("StdDevPenalty")->value());
+    simulationBackend = root_node->first_node("CellAutomata")->first_node("SimulationBackend")->value();
+    gollyInstances = atoi(root_node->first_node("CellAutomata")->first_node("GollyInstances")->value());
+    parallelMode = root_node->first_node("GeneticAlgo")->first_node("ParallelMode")->value();
+    workerThreadNum = atoi(root_node->first_node("GeneticAlgo")->first_node("WorkerThreadNumber")->value());
+    fitnessCacheEnabled = atoi(root_node->first_node("FitnessCache")->first_node("Enabled")->value()) != 0;
+    fitnessCacheFile = root_node->first_node("FitnessCache")->first_node("CacheFile")->value();
+    checkpointEnabled = atoi(root_node->first_node("Checkpoint")->first_node("Enabled")->value()) != 0;
+    checkpointFile = root_node->first_node("Checkpoint")->first_node("CheckpointFile")->value();
+    distributedMode = root_node->first_node("Distributed")->first_node("Mode")->value();
+    workerPort = atoi(root_node->first_node("Distributed")->first_node("Port")->value());
+    workerAddresses = root_node->first_node("Distributed")->first_node("Workers")->value();
+    instrumentFile = root_node->first_node("Instrumentation")->first_node("OutputFile")->value();
+    instrumentFormat = root_node->first_node("Instrumentation")->first_node("Format")->value();
+    sweepEnabled = atoi(root_node->first_node("Sweep")->first_node("Enabled")->value()) != 0;
+    useOracle = atoi(root_node->first_node("Sweep")->first_node("UseOracle")->value()) != 0;
+    oracleFile = root_node->first_node("Sweep")->first_node("OracleFile")->value();
+    sweepBand = root_node->first_node("Sweep")->first_node("Band")->value();
+    sweepFirst = atoi(root_node->first_node("Sweep")->first_node("First")->value());
+    sweepLast = atoi(root_node->first_node("Sweep")->first_node("Last")->value());
+    generationFormat = root_node->first_node("FileLocations")->first_node("GenerationFormat")->value();
+    compressDumps = atoi(root_node->first_node("FileLocations")->first_node("CompressDumps")->value()) != 0;
+    nativeDumpDir = root_node->first_node("FileLocations")->first_node("NativeDumpDir")->value();
 
     activeWeight = atof(root_node->first_node("GeneticAlgo")->first_node("FitnessFunction")->first_node("Weights")->first_node("ActiveWeight")->value());
     percentWeight = atof(root_node->first_node("GeneticAlgo")->first_node("FitnessFunction")->first_node("Weights")->first_node("PercentWeight")->value());
@@ -333,22 +1283,152 @@ void readConfig() {
 int main() {
     // Read Config File
     readConfig();
+#ifndef CAGA_WITH_CUDA
+    if (simulationBackend == "Gpu") {
+        fprintf(stderr, "The Gpu backend needs a build with CAGA_WITH_CUDA\n");
+        return 1;
+    }
+#endif
+    if (distributedMode == "Worker") {
+        serve_worker();
+        return 0;
+    }
 
     // Create initial population with random rulesets
-    srand((unsigned)(time(0))); 
+    rng.seed((unsigned)(time(0))); 
+    // A checkpointed run carries on from its last GA generation, on the Soup
+    // it was started with. A sweep carries on from its oracle file instead
+    Checkpoint checkpoint;
+    bool resumed = checkpointEnabled && !sweepEnabled && checkpoint.load(checkpointFile);
+    if (resumed) {
+        if (soupSeed != 0 && soupSeed != checkpoint.soupSeed) {
+            throw "Checkpoint file is from a run with another Seed";
+        }
+        soupSeed = checkpoint.soupSeed;
+    }
+    // Seed 0 picks a new Soup every run, print it so the run can be repeated
+    const bool seedFromTime = soupSeed == 0;
+    if (seedFromTime) {
+        soupSeed = (unsigned)(time(0));
+    }
+    printf("%8s%u\n\n", "Soup Seed: ", soupSeed);
+    if (gollyInstances < 1) {
+        gollyInstances = 1;
+    }
+    // golly-script.py fills its one Soup itself
+    if (simulationBackend == "Golly" || soupCount < 1) {
+        soupCount = 1;
+    }
+    // Cached Metrics are only reused by runs that simulate the same way
+    string paramsKey = "backend=" + simulationBackend + ";seed=" + to_string(soupSeed)
+        + ";grid=" + to_string(gridSize) + ";fill=" + to_string(gridFillPerc)
+        + ";time=" + to_string(timeElapsed) + ";stat=" + to_string(statCalcPercent);
+    // No later run gets the Soup of a Seed picked from the time, so its
+    // Metrics are only kept in memory instead of piling up in the file
+    unique_ptr<FitnessCache> cache;
+    if (fitnessCacheEnabled) {
+        cache.reset(new FitnessCache(paramsKey, seedFromTime ? "" : fitnessCacheFile));
+        fitnessCache = cache.get();
+    }
+    // A sweep only holds for runs that simulate the same way too
+    unique_ptr<RuleOracle> oracle;
+    if (sweepEnabled) {
+        if (simulationBackend != "Native" && simulationBackend != "HashLife") {
+            throw "Only the Native and HashLife backends can sweep";
+        }
+        oracle.reset(new RuleOracle(paramsKey, oracleFile, soupCount));
+    } else if (useOracle) {
+        oracle.reset(new RuleOracle(paramsKey, oracleFile, 0));
+        ruleOracle = oracle.get();
+    }
+    // A checkpoint's Fitness only holds for a run that breeds and scores
+    // the same way
+    ostringstream runParams;
+    runParams << paramsKey << ";soups=" << soupCount << "," << adaptiveSoups << "," << minSoupCount
+        << "," << maxSoupStdError << "," << soupStdDevPenalty << ";population=" << populationSize
+        << ";elitism=" << elitismPercent << ";crossover=" << crossoverRate << ";mutation=" << mutationRate
+        << ";weights=" << activeWeight << "," << percentWeight << "," << aliveWeight
+        << ";ideal=" << activeMin << "," << activeMax << "," << percentMin << "," << percentMax
+        << "," << aliveMin << "," << aliveMax;
+    const string runKey = runParams.str();
     string rules;
     vector<Individual> population; 
     bool found = false;
-    generatePatterns(true); // Reset XML
-    for(int i = 0;i < populationSize; i++) { 
-        string gnome = create_gnome(); 
-        population.push_back(Individual(gnome)); 
+    if (resumed) {
+        if (checkpoint.runKey != runKey) {
+            throw "Checkpoint file is from a run with other parameters";
+        }
+        if (checkpoint.geneCount != GENE_COUNT) {
+            throw "Checkpoint file has chromosomes of another length";
+        }
+        generation = checkpoint.generation;
+        // Checkpoints of an older generator don't hold four numbers
+        istringstream state(checkpoint.rngState);
+        if (!(state >> rng) || !(state >> ws).eof()) {
+            throw "Checkpoint file's generator state can't be resumed";
+        }
+        population.reserve(populationSize);
+        for(size_t i = 0; i < checkpoint.chromosomes.size(); i++) {
+            population.push_back(Individual(checkpoint.chromosomes[i]));
+            population.back().fitness = checkpoint.fitness[i];
+        }
+        if (fitnessCache != nullptr && checkpoint.cacheEntries != "") {
+            istringstream entries(checkpoint.cacheEntries);
+            fitnessCache->loadFrom(entries);
+        }
+        printf("%8s%d\n\n", "Resumed at Generation: ", generation);
+    }
+    if (simulationBackend == "Golly") {
+        // golly-script.py simulates the generation after the resumed one next
+        generatePatterns(true, resumed ? generation + 1 : 0); // Reset XML
+    }
+    // A coordinator keeps a thread per worker connection busy
+    unique_ptr<RemoteWorkers> workers;
+    if (distributedMode == "Coordinator") {
+        if (simulationBackend != "Native" && simulationBackend != "HashLife") {
+            throw "Only the Native and HashLife backends can run on workers";
+        }
+        vector<string> addresses;
+        stringstream list(workerAddresses);
+        string address;
+        while (getline(list, address, ',')) {
+            if (address != "") {
+                addresses.push_back(address);
+            }
+        }
+        workers.reset(new RemoteWorkers(addresses, simulation_params()));
+        remoteWorkers = workers.get();
+        parallelMode = "InterRule";
+        workerThreadNum = max(1, remoteWorkers->size());
+    }
+    // Workers are started once and reused every Generation
+    unique_ptr<ThreadPool> pool;
+    if (parallelMode == "InterRule" || (parallelMode == "Batch" && simulationBackend != "Native"
+            && simulationBackend != "Gpu")) {
+        pool.reset(new ThreadPool(workerThreadNum));
+    }
+    if (sweepEnabled) {
+        if (!pool) {
+            pool.reset(new ThreadPool(workerThreadNum));
+        }
+        sweep_rules(*oracle, pool.get());
+        return 0;
+    }
+    population.reserve(populationSize);
+    for(int i = population.size();i < populationSize; i++) { 
+        population.push_back(Individual(create_gnome())); 
     } 
     // Until target is found, crossover and mutate individuals
     while(!found) {
-        toFile(population, generation);
-        generatePatterns(false);
-        cal_PopFitness(population);
+        // A resumed generation's Fitness is in the checkpoint already
+        if (resumed) {
+            resumed = false;
+        } else {
+            evaluate_generation(population, pool.get());
+            if (checkpointEnabled) {
+                save_checkpoint(population, runKey);
+            }
+        }
         sort(population.begin(), population.end());
         // Converge after five Generations
         if(generation == convergeGen) { 
@@ -356,6 +1436,7 @@ int main() {
             break; 
         } 
         vector<Individual> new_generation; 
+        new_generation.reserve(populationSize);
         // Send the top percentage through to the next generation with no
         // crossover or mutation
         int s = (elitismPercent * populationSize) / 100; 
@@ -369,22 +1450,21 @@ int main() {
         for(int i = 0; i < s; i++) {  
             // Choose random parent from top percentage of performers
             int r = random_num(0, c); 
-            Individual parent1 = population[r]; 
+            const Individual& parent1 = population[r]; 
             r = random_num(0, c); 
-            Individual parent2 = population[r]; 
-            Individual offspring = parent1.mate(parent2);
+            const Individual& parent2 = population[r]; 
             // Append to New Generation
-            new_generation.push_back(offspring);  
+            new_generation.push_back(parent1.mate(parent2));  
         }
         // Assign New Population
-        population = new_generation;
+        population = std::move(new_generation);
         // Print Top Performer
-        printf("%8s%23s%13s%5.3f%16s%d\n\n", "Top Ruleset: ", decode(population[0].chromosome).c_str(),
+        printf("%8s%23s%13s%5.3f%16s%d\n\n", "Top Ruleset: ", decode(population[0].genes).c_str(),
             "Fitness: ", population[0].fitness, "Generation: ", generation);
         generation++; 
     }
     // Print Top Performer of Last Generation
-    printf("%8s%23s%13s%5.3f%16s%d\n", "Top Ruleset: ", decode(population[0].chromosome).c_str(),
+    printf("%8s%23s%13s%5.3f%16s%d\n", "Top Ruleset: ", decode(population[0].genes).c_str(),
         "Fitness: ", population[0].fitness, "Generation: ", generation);
     dump();
 }
@@ -5,6 +5,8 @@
 
 # Element Tree for XML Parsing
 import xml.etree.ElementTree as ET
+# Sys Library for the Generation to Reset to
+import sys
 
 # Retrieve Settings from XML
 tree = ET.parse('config.xml')
@@ -12,6 +14,7 @@ root = tree.getroot()
 # Set Up XML Tree Root
 rootGA = root.find("GeneticAlgo")
 newGen = rootGA.find("CurrentGeneration")
-# Reset Current Generation to 0
-newGen.text = str(0)
+# Reset Current Generation to 0, or to the Generation given when a Run is
+# Resumed from its Checkpoint
+newGen.text = sys.argv[1] if len(sys.argv) > 1 else str(0)
 tree.write('config.xml')
@@ -0,0 +1,250 @@
+/*
+ * File:         benchClassifier.cpp
+ * Author:       Carter Hale
+ * Date Created: October 14, 2026
+ * Last Updated: October 14, 2026
+ *
+ * Benchmarks the ConwayClassifier on Generations made by the LifeSimulator
+ * for a few known Rulesets over a grid of Soup sizes, Generation counts and
+ * thread counts. Every case is classified from .rle files (like Golly
+ * saves them), from a generation dump, from the frames in memory and in
+ * streaming mode, and the time of each phase of the Classifier is printed
+ * as one JSON object per line (or CSV with --csv) so runs can be compared.
+ *
+ * Build from this directory with
+ *   g++ -std=c++17 -O2 -pthread -DCAGA_INSTRUMENT -I../System
+ *       benchClassifier.cpp ../System/ConwayClassifier.cpp
+ *       ../System/GenerationFrame.cpp ../System/GenerationWindow.cpp
+ *       ../System/GenerationDump.cpp ../System/RleReader.cpp
+ *       ../System/LifeSimulator.cpp ../System/SimulationEngine.cpp
+ *       ../System/Instrumentation.cpp ../System/BoardArena.cpp
+ *       -o benchClassifier
+ * (without CAGA_INSTRUMENT every phase reads 0 and only the totals are kept)
+ *
+ * Usage: benchClassifier [--csv] [--quick] [--reps N] [--dir PATH]
+ *   --csv    print CSV instead of JSON lines
+ *   --quick  only the smallest Soup and Generation count
+ *   --reps   runs of every case, the fastest one is printed (default 3)
+ *   --dir    where the datasets are written (default /tmp/benchClassifier)
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include "ConwayClassifier.h"
+#include "GenerationDump.h"
+#include "LifeSimulator.h"
+
+// Known Rulesets: Life, HighLife and the Replicator, which grows fastest
+const std::vector<std::string> RULESETS = {"b3/s23", "b36/s23", "b1357/s1357"};
+const std::vector<int> GRID_SIZES = {64, 128, 256};
+const std::vector<int> GEN_COUNTS = {100, 300};
+const std::vector<int> THREAD_COUNTS = {1, 2, 4};
+// Soup the same way the GA fills it
+const int FILL_PERCENT = 25;
+const unsigned int SEED = 1;
+const int STAT_PERCENT = 30;
+
+// Names of the phases in the order they are printed
+const std::vector<std::string> PHASES = {"readGens", "class1Check",
+    "class2Check", "boardSpecs", "allocateBoard", "fillBoard",
+    "activeCellRatio", "pushGenerations"};
+
+/*
+ * Turns a Ruleset like b3/s23 into the GA's 18 gene Chromosome
+ */
+std::string toChromosome(const std::string& ruleSet) {
+    std::string chromosome(18, '0');
+    int offset = 0;
+    for (char c : ruleSet) {
+        if (c == 's') {
+            offset = 9;
+        } else if (c >= '0' && c <= '8') {
+            chromosome[offset + (c - '0')] = '1';
+        }
+    }
+    return chromosome;
+}
+
+/*
+ * Phase times in the order of PHASES
+ */
+std::vector<double> phaseList(const ConwayClassifier::PhaseTimes& t) {
+    return {t.readGens, t.class1Check, t.class2Check, t.boardSpecs,
+        t.allocateBoard, t.fillBoard, t.activeCellRatio, t.pushGenerations};
+}
+
+/*
+ * One measured case, the fastest of its runs
+ */
+struct Result {
+    std::string source;
+    std::string ruleSet;
+    int gridSize;
+    int genNum;
+    int threads;
+    int frameCount;
+    int classNum;
+    double total;
+    std::vector<double> phases;
+};
+
+/*
+ * Prints a Result as a JSON object or a CSV row
+ */
+void printResult(const Result& r, const bool csv) {
+    std::ostringstream out;
+    if (csv) {
+        out << r.source << "," << r.ruleSet << "," << r.gridSize << ","
+            << r.genNum << "," << r.threads << "," << r.frameCount << ","
+            << r.classNum << "," << r.total;
+        for (double p : r.phases) {
+            out << "," << p;
+        }
+    } else {
+        out << "{\"source\":\"" << r.source << "\",\"rule\":\"" << r.ruleSet
+            << "\",\"grid\":" << r.gridSize << ",\"gens\":" << r.genNum
+            << ",\"threads\":" << r.threads << ",\"frames\":" << r.frameCount
+            << ",\"class\":" << r.classNum << ",\"total\":" << r.total;
+        for (size_t i = 0; i < PHASES.size(); i++) {
+            out << ",\"" << PHASES[i] << "\":" << r.phases[i];
+        }
+        out << "}";
+    }
+    std::cout << out.str() << std::endl;
+}
+
+/*
+ * Runs classify reps times and keeps the fastest run
+ */
+template<typename Classify>
+void measure(Result& r, const int reps, Classify classify) {
+    r.total = -1;
+    for (int rep = 0; rep < reps; rep++) {
+        auto start = std::chrono::steady_clock::now();
+        ConwayClassifier* c = classify();
+        double total = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        if (r.total < 0 || total < r.total) {
+            r.total = total;
+            r.classNum = c->classification();
+            r.phases = phaseList(c->getPhaseTimes());
+        }
+        delete c;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // Read Options
+    bool csv = false;
+    bool quick = false;
+    int reps = 3;
+    std::string baseDir = "/tmp/benchClassifier";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--csv") {
+            csv = true;
+        } else if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--reps" && i + 1 < argc) {
+            reps = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--dir" && i + 1 < argc) {
+            baseDir = argv[++i];
+        } else {
+            std::cerr << "Usage: benchClassifier [--csv] [--quick] [--reps N] [--dir PATH]" << std::endl;
+            return 1;
+        }
+    }
+    const std::vector<int> gridSizes = quick ? std::vector<int>{GRID_SIZES[0]} : GRID_SIZES;
+    const std::vector<int> genCounts = quick ? std::vector<int>{GEN_COUNTS[0]} : GEN_COUNTS;
+    if (csv) {
+        std::cout << "source,rule,grid,gens,threads,frames,class,total";
+        for (const std::string& p : PHASES) {
+            std::cout << "," << p;
+        }
+        std::cout << std::endl;
+    }
+
+    try {
+        for (const std::string& ruleSet : RULESETS) {
+            std::string rule = ruleSet;
+            rule[rule.find('/')] = '_';
+            for (int gridSize : gridSizes) {
+                for (int genNum : genCounts) {
+                    // Simulate once the way golly-script.py does, stopping
+                    // only when the Universe is empty or stops changing
+                    std::vector<GenerationFrame> frames;
+                    LifeSimulator sim(toChromosome(ruleSet), gridSize, FILL_PERCENT, SEED);
+                    sim.run(genNum, [&](const GenerationFrame& frame) {
+                        frames.push_back(frame);
+                    }, false);
+
+                    // Write the Datasets, a directory of .rle files named
+                    // after the Rule and a generation dump
+                    std::string caseDir = baseDir + "/" + rule + "_" + std::to_string(gridSize)
+                        + "_" + std::to_string(genNum);
+                    std::string rleDir = caseDir + "/" + rule;
+                    std::string dumpPath = caseDir + "/" + rule + ".gdump";
+                    std::filesystem::remove_all(caseDir);
+                    std::filesystem::create_directories(rleDir);
+                    GenerationDumpWriter dump(dumpPath, rule, false);
+                    for (size_t gen = 0; gen < frames.size(); gen++) {
+                        std::ofstream out(rleDir + "/" + rule + "_" + std::to_string(gen) + ".rle");
+                        out << frames[gen].toRle(ruleSet, gen);
+                        dump.write(frames[gen]);
+                    }
+                    dump.close();
+
+                    Result r;
+                    r.ruleSet = ruleSet;
+                    r.gridSize = gridSize;
+                    r.genNum = genNum;
+                    r.frameCount = frames.size();
+                    for (int threads : THREAD_COUNTS) {
+                        r.threads = threads;
+                        r.source = "rle";
+                        measure(r, reps, [&]() {
+                            return new ConwayClassifier(rleDir, genNum, threads, STAT_PERCENT);
+                        });
+                        printResult(r, csv);
+                        r.source = "dump";
+                        measure(r, reps, [&]() {
+                            return new ConwayClassifier(dumpPath, genNum, threads, STAT_PERCENT);
+                        });
+                        printResult(r, csv);
+                        r.source = "frames";
+                        measure(r, reps, [&]() {
+                            return new ConwayClassifier(rule, frames, genNum, threads, STAT_PERCENT);
+                        });
+                        printResult(r, csv);
+                    }
+                    // Streaming mode is single threaded
+                    r.threads = 1;
+                    r.source = "stream";
+                    measure(r, reps, [&]() {
+                        ConwayClassifier* c = new ConwayClassifier(rule, genNum, STAT_PERCENT);
+                        for (const GenerationFrame& frame : frames) {
+                            c->pushGeneration(frame);
+                        }
+                        c->finishGenerations();
+                        return c;
+                    });
+                    printResult(r, csv);
+                    std::filesystem::remove_all(caseDir);
+                }
+            }
+        }
+    } catch (const char* error) {
+        std::cerr << "Benchmark failed: " << error << std::endl;
+        return 1;
+    }
+    return 0;
+}